@@ -0,0 +1,297 @@
+#include "BinaryFuseFilter.h"
+
+#include "Fingerprint.h"
+#include "SortedWordSet.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <ostream>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace
+{
+    char constexpr     MAGIC[4]       = { 'R', 'W', 'G', 'F' };
+    uint32_t constexpr VERSION        = 1;
+    size_t constexpr   HEADER_SIZE    = 40;
+    int constexpr      MAX_ITERATIONS = 100;
+
+    // File layout (little-endian):
+    //
+    //      0   magic
+    //      4   version
+    //      8   seed
+    //      16  segment length
+    //      20  segment length mask
+    //      24  segment count
+    //      28  segment count * segment length
+    //      32  number of fingerprints
+    //      36  reserved
+    //      40  fingerprints
+
+    uint64_t mulhi(uint64_t a, uint64_t b)
+    {
+#if defined(_MSC_VER)
+        return __umulh(a, b);
+#else
+        return (uint64_t)(((__uint128_t)a * b) >> 64);
+#endif
+    }
+
+    uint8_t fingerprint(uint64_t hash)
+    {
+        return (uint8_t)(hash ^ (hash >> 32));
+    }
+
+    template <typename T>
+    T load(uint8_t const * p)
+    {
+        T v;
+        memcpy(&v, p, sizeof(v));
+        return v;
+    }
+
+    template <typename T>
+    void store(std::ostream & s, T v)
+    {
+        s.write(reinterpret_cast<char const *>(&v), sizeof(v));
+    }
+}
+
+//! @param  words   Words in the set
+//! @param  out     Receives the filter
+//!
+//! @return     false if the filter could not be built or written
+
+bool BinaryFuseFilter::write(std::vector<std::string> const & words, std::ostream & out)
+{
+    std::vector<uint64_t> keys;
+    keys.reserve(words.size());
+    for (auto const & word : words)
+    {
+        keys.push_back(WordFingerprint::of(word));
+    }
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+
+    uint32_t size = (uint32_t)keys.size();
+
+    // Compute the layout. The segments are sized so that construction almost always succeeds on the first try.
+    Layout   layout        = {};
+    uint32_t segmentLength = (size == 0) ? 4 : 1u << (int)std::floor(std::log((double)size) / std::log(3.33) + 2.25);
+    segmentLength          = std::min(segmentLength, 262144u);
+    double sizeFactor      = (size <= 1) ? 0.0 : std::max(1.125, 0.875 + 0.25 * std::log(1000000.0) / std::log((double)size));
+    uint32_t capacity      = (size <= 1) ? 0 : (uint32_t)std::round((double)size * sizeFactor);
+    uint32_t segmentCount  = (capacity + segmentLength - 1) / segmentLength;
+    segmentCount           = (segmentCount <= 2) ? 1 : segmentCount - 2;
+
+    layout.segmentLength      = segmentLength;
+    layout.segmentLengthMask  = segmentLength - 1;
+    layout.segmentCount       = segmentCount;
+    layout.segmentCountLength = segmentCount * segmentLength;
+    layout.arrayLength        = (segmentCount + 2) * segmentLength;
+
+    uint32_t             arrayLength = layout.arrayLength;
+    std::vector<uint8_t> fingerprints(arrayLength, 0);
+
+    std::vector<uint64_t> reverseOrder(size + 1);
+    std::vector<uint8_t>  reverseH(size);
+    std::vector<uint8_t>  t2count(arrayLength);
+    std::vector<uint64_t> t2hash(arrayLength);
+    std::vector<uint32_t> alone(arrayLength);
+
+    int blockBits = 1;
+    while ((1u << blockBits) < segmentCount)
+    {
+        ++blockBits;
+    }
+    std::vector<uint32_t> startPos(1u << blockBits);
+    uint32_t              blockMask = (1u << blockBits) - 1;
+
+    uint64_t seedState = 0x726b2b9d438b9d4dull;
+    uint32_t stackSize = 0;
+    bool     built     = false;
+    for (int iteration = 0; iteration < MAX_ITERATIONS && !built; ++iteration)
+    {
+        seedState  += 0x9e3779b97f4a7c15ull;
+        layout.seed = WordFingerprint::mix(seedState);
+
+        std::fill(reverseOrder.begin(), reverseOrder.end(), 0);
+        std::fill(t2count.begin(), t2count.end(), 0);
+        std::fill(t2hash.begin(), t2hash.end(), 0);
+        reverseOrder[size] = 1;
+
+        // Order the keys roughly by segment, which makes the peeling cache-friendly
+        for (uint32_t i = 0; i < (1u << blockBits); ++i)
+        {
+            startPos[i] = (uint32_t)(((uint64_t)i * size) >> blockBits);
+        }
+        for (uint32_t i = 0; i < size; ++i)
+        {
+            uint64_t hash    = WordFingerprint::mix(keys[i] + layout.seed);
+            uint32_t segment = (uint32_t)(hash >> (64 - blockBits));
+            while (reverseOrder[startPos[segment]] != 0)
+            {
+                segment = (segment + 1) & blockMask;
+            }
+            reverseOrder[startPos[segment]] = hash;
+            ++startPos[segment];
+        }
+
+        // Count the keys mapped to each position. The low 2 bits accumulate which of the three positions of a key this
+        // is, so that a position with a single key knows the other two.
+        bool overflow = false;
+        for (uint32_t i = 0; i < size; ++i)
+        {
+            uint64_t hash = reverseOrder[i];
+            uint32_t h[3];
+            positions(layout, hash, h);
+            for (int k = 0; k < 3; ++k)
+            {
+                t2count[h[k]] += 4;
+                t2count[h[k]] ^= (uint8_t)k;
+                t2hash[h[k]]  ^= hash;
+                overflow       = overflow || t2count[h[k]] < 4;
+            }
+        }
+        if (overflow)
+            continue;
+
+        // Peel positions that have a single key
+        uint32_t queueSize = 0;
+        for (uint32_t i = 0; i < arrayLength; ++i)
+        {
+            alone[queueSize] = i;
+            queueSize       += ((t2count[i] >> 2) == 1) ? 1 : 0;
+        }
+
+        stackSize = 0;
+        while (queueSize > 0)
+        {
+            uint32_t index = alone[--queueSize];
+            if ((t2count[index] >> 2) != 1)
+                continue;
+
+            uint64_t hash  = t2hash[index];
+            uint8_t  found = t2count[index] & 3;
+            reverseH[stackSize]     = found;
+            reverseOrder[stackSize] = hash;
+            ++stackSize;
+
+            uint32_t h[3];
+            positions(layout, hash, h);
+            for (int k = 1; k <= 2; ++k)
+            {
+                uint8_t  which = (uint8_t)((found + k) % 3);
+                uint32_t other = h[which];
+                alone[queueSize] = other;
+                queueSize       += ((t2count[other] >> 2) == 2) ? 1 : 0;
+                t2count[other]  -= 4;
+                t2count[other]  ^= which;
+                t2hash[other]   ^= hash;
+            }
+        }
+
+        built = (stackSize == size);
+    }
+
+    if (!built)
+        return false;
+
+    // Assign the fingerprints in the reverse order of peeling
+    for (uint32_t i = stackSize; i-- > 0;)
+    {
+        uint64_t hash  = reverseOrder[i];
+        uint8_t  found = reverseH[i];
+        uint32_t h[3];
+        positions(layout, hash, h);
+        fingerprints[h[found]] = fingerprint(hash) ^ fingerprints[h[(found + 1) % 3]] ^ fingerprints[h[(found + 2) % 3]];
+    }
+
+    out.write(MAGIC, sizeof(MAGIC));
+    store(out, VERSION);
+    store(out, layout.seed);
+    store(out, layout.segmentLength);
+    store(out, layout.segmentLengthMask);
+    store(out, layout.segmentCount);
+    store(out, layout.segmentCountLength);
+    store(out, layout.arrayLength);
+    store(out, (uint32_t)0);
+    out.write(reinterpret_cast<char const *>(fingerprints.data()), fingerprints.size());
+
+    return (bool)out;
+}
+
+//! @param  filename    Name of a file written by write()
+//!
+//! @return     true if the filter was opened
+
+bool BinaryFuseFilter::open(char const * filename)
+{
+    fingerprints_ = nullptr;
+
+    if (!file_.open(filename))
+        return false;
+
+    uint8_t const * data = file_.data();
+    size_t          size = file_.size();
+    if (size < HEADER_SIZE || memcmp(data, MAGIC, sizeof(MAGIC)) != 0 || load<uint32_t>(data + 4) != VERSION)
+        return false;
+
+    Layout layout;
+    layout.seed               = load<uint64_t>(data + 8);
+    layout.segmentLength      = load<uint32_t>(data + 16);
+    layout.segmentLengthMask  = load<uint32_t>(data + 20);
+    layout.segmentCount       = load<uint32_t>(data + 24);
+    layout.segmentCountLength = load<uint32_t>(data + 28);
+    layout.arrayLength        = load<uint32_t>(data + 32);
+
+    if (layout.segmentLength == 0 || layout.segmentLengthMask != layout.segmentLength - 1 ||
+        (layout.segmentLength & layout.segmentLengthMask) != 0 ||
+        (uint64_t)layout.segmentCount * layout.segmentLength != layout.segmentCountLength ||
+        (uint64_t)layout.segmentCountLength + 2 * (uint64_t)layout.segmentLength != layout.arrayLength ||
+        size - HEADER_SIZE < layout.arrayLength)
+    {
+        return false;
+    }
+
+    layout_       = layout;
+    fingerprints_ = data + HEADER_SIZE;
+    return true;
+}
+
+//! @param  word    Word to find
+//!
+//! @return     false if the word is definitely not in the set
+
+bool BinaryFuseFilter::mayContain(std::string_view word) const
+{
+    if (!fingerprints_)
+        return false;
+
+    uint64_t hash = WordFingerprint::mix(WordFingerprint::of(word) + layout_.seed);
+    uint32_t h[3];
+    positions(layout_, hash, h);
+    return (fingerprint(hash) ^ fingerprints_[h[0]] ^ fingerprints_[h[1]] ^ fingerprints_[h[2]]) == 0;
+}
+
+//! @param  word    Word to check
+//!
+//! @return     true if the word may be in the filter, and it is in the confirmation set if one has been set
+
+bool BinaryFuseFilter::rejects(std::string_view word)
+{
+    return mayContain(word) && (!confirmation_ || confirmation_->contains(word));
+}
+
+void BinaryFuseFilter::positions(Layout const & layout, uint64_t hash, uint32_t h[3])
+{
+    h[0] = (uint32_t)mulhi(hash, layout.segmentCountLength);
+    h[1] = h[0] + layout.segmentLength;
+    h[2] = h[1] + layout.segmentLength;
+    h[1] ^= (uint32_t)(hash >> 18) & layout.segmentLengthMask;
+    h[2] ^= (uint32_t)hash & layout.segmentLengthMask;
+}
@@ -0,0 +1,545 @@
+#include "BulkWriter.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(_WIN32)
+#include <fcntl.h>
+#include <io.h>
+#include <malloc.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define RANDOMWORDGENERATOR_IO_URING 1
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+namespace
+{
+    size_t constexpr DIRECT_ALIGNMENT = 4096;
+}
+
+#if defined(RANDOMWORDGENERATOR_IO_URING)
+
+// A minimal io_uring driven directly through the system calls, so that liburing is not required
+struct BulkWriter::Ring
+{
+    ~Ring()
+    {
+        if (sqes)
+            munmap(sqes, sqesSize);
+        if (cqRing && cqRing != sqRing)
+            munmap(cqRing, cqRingSize);
+        if (sqRing)
+            munmap(sqRing, sqRingSize);
+        if (fd >= 0)
+            ::close(fd);
+    }
+
+    bool setup(unsigned entries)
+    {
+        io_uring_params params;
+        memset(&params, 0, sizeof(params));
+        fd = (int)syscall(__NR_io_uring_setup, entries, &params);
+        if (fd < 0)
+            return false;
+
+        sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        if (params.features & IORING_FEAT_SINGLE_MMAP)
+            sqRingSize = cqRingSize = std::max(sqRingSize, cqRingSize);
+
+        sqRing = mmap(nullptr, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+        if (sqRing == MAP_FAILED)
+        {
+            sqRing = nullptr;
+            return false;
+        }
+        if (params.features & IORING_FEAT_SINGLE_MMAP)
+        {
+            cqRing = sqRing;
+        }
+        else
+        {
+            cqRing = mmap(nullptr, cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+            if (cqRing == MAP_FAILED)
+            {
+                cqRing = nullptr;
+                return false;
+            }
+        }
+
+        sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+        void * s = mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+        if (s == MAP_FAILED)
+            return false;
+        sqes = static_cast<io_uring_sqe *>(s);
+
+        char * sq = static_cast<char *>(sqRing);
+        char * cq = static_cast<char *>(cqRing);
+        sqTail  = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+        sqMask  = *reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+        sqArray = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+        cqHead  = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+        cqTail  = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+        cqMask  = *reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+        cqes    = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+        return true;
+    }
+
+    int            fd         = -1;
+    void *         sqRing     = nullptr;
+    size_t         sqRingSize = 0;
+    void *         cqRing     = nullptr;
+    size_t         cqRingSize = 0;
+    io_uring_sqe * sqes       = nullptr;
+    size_t         sqesSize   = 0;
+    unsigned *     sqTail     = nullptr;
+    unsigned       sqMask     = 0;
+    unsigned *     sqArray    = nullptr;
+    unsigned *     cqHead     = nullptr;
+    unsigned *     cqTail     = nullptr;
+    unsigned       cqMask     = 0;
+    io_uring_cqe * cqes       = nullptr;
+};
+
+#else
+
+struct BulkWriter::Ring
+{
+};
+
+#endif
+
+BulkWriter::BulkWriter()
+    : nextOffset_(0)
+    , inFlight_(0)
+    , failed_(false)
+{
+}
+
+BulkWriter::~BulkWriter()
+{
+    close();
+}
+
+//! @param  filename    Name of the file to write
+//! @param  options     Buffer sizes and write mode
+//!
+//! @return     true if the file was opened
+
+bool BulkWriter::open(char const * filename, Options const & options)
+{
+    close();
+
+    options_ = options;
+#if defined(_WIN32) || !defined(O_DIRECT)
+    options_.direct = false;
+#endif
+    if (options_.bufferCount == 0 || options_.bufferSize == 0 || (options_.direct && options_.queueDepth == 0))
+        return false;
+    if (options_.direct)
+        options_.bufferSize = (options_.bufferSize + DIRECT_ALIGNMENT - 1) / DIRECT_ALIGNMENT * DIRECT_ALIGNMENT;
+
+#if defined(_WIN32)
+    fd_ = _open(filename, _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+    int flags = O_WRONLY | O_CREAT | O_TRUNC;
+#if defined(O_DIRECT)
+    if (options_.direct)
+        flags |= O_DIRECT;
+#endif
+    fd_ = ::open(filename, flags, 0644);
+#endif
+    if (fd_ < 0)
+        return false;
+    filename_ = filename;
+
+    unsigned stageCount = options_.direct ? options_.queueDepth : 0;
+    unsigned count      = options_.bufferCount + stageCount;
+    size_t   total      = options_.bufferSize * count;
+#if defined(_WIN32)
+    memory_ = static_cast<char *>(_aligned_malloc(total, DIRECT_ALIGNMENT));
+#else
+    void * memory = nullptr;
+    memory_       = (posix_memalign(&memory, DIRECT_ALIGNMENT, total) == 0) ? static_cast<char *>(memory) : nullptr;
+#endif
+    if (!memory_)
+    {
+        close();
+        return false;
+    }
+
+    buffers_.resize(count);
+    for (unsigned i = 0; i < count; ++i)
+    {
+        buffers_[i] = { memory_ + i * options_.bufferSize, 0, options_.bufferSize, i, 0, 0 };
+        if (i < options_.bufferCount)
+            free_.push_back(&buffers_[i]);
+        else
+            freeStages_.push_back(&buffers_[i]);
+    }
+
+#if defined(RANDOMWORDGENERATOR_IO_URING)
+    // Fall back to pwritev if io_uring is not available or the buffers cannot be registered
+    ring_ = std::make_unique<Ring>();
+    bool ok = ring_->setup(count);
+    if (ok)
+    {
+        std::vector<iovec> iovecs(count);
+        for (unsigned i = 0; i < count; ++i)
+        {
+            iovecs[i] = { buffers_[i].data, buffers_[i].capacity };
+        }
+        ok = syscall(__NR_io_uring_register, ring_->fd, IORING_REGISTER_BUFFERS, iovecs.data(), count) == 0;
+    }
+    if (!ok)
+        ring_.reset();
+#endif
+
+    return true;
+}
+
+//! @return     false if the file was not open or any write failed
+
+bool BulkWriter::close()
+{
+    if (fd_ < 0)
+        return false;
+
+    // Stop waiting if a write has failed. Closing the ring cancels the writes still in flight.
+    while (inFlight_ > 0 && !failed_)
+    {
+        reap(true);
+    }
+    if (inFlight_ > 0)
+        reap(false);
+    writeTail();
+    ring_.reset();
+
+#if defined(_WIN32)
+    bool ok = _close(fd_) == 0;
+    _aligned_free(memory_);
+#else
+    bool ok = ::close(fd_) == 0;
+    free(memory_);
+#endif
+
+    ok = ok && !failed_;
+
+    fd_     = -1;
+    memory_ = nullptr;
+    stage_  = nullptr;
+    buffers_.clear();
+    free_.clear();
+    freeStages_.clear();
+    nextOffset_ = 0;
+    inFlight_   = 0;
+    failed_     = false;
+    filename_.clear();
+    return ok;
+}
+
+//! @return     an empty buffer
+
+BulkWriter::Buffer * BulkWriter::acquire()
+{
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(freeMutex_);
+            if (!free_.empty())
+            {
+                Buffer * buffer = free_.back();
+                free_.pop_back();
+                buffer->size = 0;
+                return buffer;
+            }
+            bool reaping = ring_ && inFlight_ > 0 && !options_.direct;
+            if (!reaping || failed_)
+            {
+                // Every buffer is being filled or submitted by another thread, or the writes in flight are collected
+                // without waiting because a write has failed
+                freeReady_.wait_for(lock, std::chrono::milliseconds(10));
+                if (!reaping)
+                    continue;
+            }
+        }
+        reap(true);
+    }
+}
+
+//! @param  buffer  Buffer to write
+//!
+//! @return     false if a write has failed
+
+bool BulkWriter::submit(Buffer * buffer)
+{
+    if (buffer->size == 0)
+    {
+        release(buffer);
+    }
+    else if (options_.direct)
+    {
+        stage(buffer);
+        release(buffer);
+    }
+    else
+    {
+        buffer->offset  = nextOffset_.fetch_add(buffer->size);
+        buffer->pending = buffer->size;
+        if (ring_)
+        {
+            queue(buffer);
+        }
+        else
+        {
+            if (!writeAt(buffer->data, buffer->size, buffer->offset, fd_))
+                failed_ = true;
+            release(buffer);
+        }
+    }
+    return !failed_;
+}
+
+void BulkWriter::release(Buffer * buffer)
+{
+    std::lock_guard<std::mutex> lock(freeMutex_);
+    if (buffer->index < options_.bufferCount)
+        free_.push_back(buffer);
+    else
+        freeStages_.push_back(buffer);
+    freeReady_.notify_all();
+}
+
+// Packs the contents of a buffer into the staging buffers, writing each one as it fills
+void BulkWriter::stage(Buffer * buffer)
+{
+    std::lock_guard<std::mutex> lock(stageMutex_);
+
+    char const * data = buffer->data;
+    size_t       size = buffer->size;
+    while (size > 0)
+    {
+        while (!stage_)
+        {
+            {
+                std::unique_lock<std::mutex> freeLock(freeMutex_);
+                if (!freeStages_.empty())
+                {
+                    stage_ = freeStages_.back();
+                    freeStages_.pop_back();
+                    stage_->size = 0;
+                    break;
+                }
+            }
+            reap(true);
+        }
+
+        size_t n = std::min(stage_->capacity - stage_->size, size);
+        memcpy(stage_->data + stage_->size, data, n);
+        stage_->size += n;
+        data         += n;
+        size         -= n;
+
+        if (stage_->size == stage_->capacity)
+        {
+            stage_->offset  = nextOffset_.fetch_add(stage_->size);
+            stage_->pending = stage_->size;
+            if (ring_)
+            {
+                queue(stage_);
+            }
+            else
+            {
+                if (!writeAt(stage_->data, stage_->size, stage_->offset, fd_))
+                    failed_ = true;
+                release(stage_);
+            }
+            stage_ = nullptr;
+        }
+    }
+}
+
+bool BulkWriter::writeAt(char const * data, size_t size, uint64_t offset, int fd)
+{
+#if defined(_WIN32)
+    std::lock_guard<std::mutex> lock(submitMutex_);
+    if (_lseeki64(fd, (__int64)offset, SEEK_SET) < 0)
+        return false;
+    while (size > 0)
+    {
+        int n = _write(fd, data, (unsigned)std::min<size_t>(size, 1u << 30));
+        if (n <= 0)
+            return false;
+        data += n;
+        size -= n;
+    }
+#else
+    while (size > 0)
+    {
+        iovec   iov = { const_cast<char *>(data), size };
+        ssize_t n   = pwritev(fd, &iov, 1, (off_t)offset);
+        if (n <= 0)
+            return false;
+        data   += n;
+        size   -= n;
+        offset += n;
+    }
+#endif
+    return true;
+}
+
+// Writes the partially filled staging buffer at the end of the file, through a descriptor that does not require alignment
+void BulkWriter::writeTail()
+{
+#if !defined(_WIN32)
+    if (!stage_ || stage_->size == 0)
+        return;
+
+    int fd = ::open(filename_.c_str(), O_WRONLY);
+    if (fd < 0 || !writeAt(stage_->data, stage_->size, nextOffset_.fetch_add(stage_->size), fd))
+        failed_ = true;
+    if (fd >= 0)
+        ::close(fd);
+    stage_ = nullptr;
+#endif
+}
+
+void BulkWriter::queue(Buffer * buffer)
+{
+#if defined(RANDOMWORDGENERATOR_IO_URING)
+    std::lock_guard<std::mutex> lock(submitMutex_);
+
+    unsigned       tail  = *ring_->sqTail;
+    unsigned       index = tail & ring_->sqMask;
+    io_uring_sqe & sqe   = ring_->sqes[index];
+    memset(&sqe, 0, sizeof(sqe));
+    sqe.opcode    = IORING_OP_WRITE_FIXED;
+    sqe.fd        = fd_;
+    sqe.addr      = (uint64_t)(uintptr_t)(buffer->data + buffer->size - buffer->pending);
+    sqe.len       = (uint32_t)buffer->pending;
+    sqe.off       = buffer->offset;
+    sqe.buf_index = (uint16_t)buffer->index;
+    sqe.user_data = buffer->index;
+    ring_->sqArray[index] = index;
+    __atomic_store_n(ring_->sqTail, tail + 1, __ATOMIC_RELEASE);
+
+    ++inFlight_;
+    long submitted;
+    do
+    {
+        submitted = syscall(__NR_io_uring_enter, ring_->fd, 1, 0, 0, nullptr, 0);
+    } while (submitted < 0 && errno == EINTR);
+    if (submitted < 0)
+    {
+        // The entry was not consumed, so take it back and write the buffer directly instead. Otherwise it would never be
+        // submitted, and close() would wait for it forever.
+        __atomic_store_n(ring_->sqTail, tail, __ATOMIC_RELEASE);
+        --inFlight_;
+        if (!writeAt(buffer->data + buffer->size - buffer->pending, buffer->pending, buffer->offset, fd_))
+            failed_ = true;
+        release(buffer);
+    }
+#else
+    (void)buffer;
+#endif
+}
+
+// Handles completed writes, optionally waiting for at least one
+void BulkWriter::reap(bool wait)
+{
+#if defined(RANDOMWORDGENERATOR_IO_URING)
+    std::lock_guard<std::mutex> lock(reapMutex_);
+
+    // Once a write or a wait has failed, completions are only collected, since waiting for them may never end
+    unsigned head = *ring_->cqHead;
+    if (wait && !failed_ && head == __atomic_load_n(ring_->cqTail, __ATOMIC_ACQUIRE) && inFlight_ > 0)
+    {
+        if (syscall(__NR_io_uring_enter, ring_->fd, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0) < 0 && errno != EINTR)
+            failed_ = true;
+    }
+
+    while (head != __atomic_load_n(ring_->cqTail, __ATOMIC_ACQUIRE))
+    {
+        io_uring_cqe const & cqe = ring_->cqes[head & ring_->cqMask];
+        Buffer *             buffer = &buffers_[cqe.user_data];
+        int                  result = cqe.res;
+        ++head;
+        __atomic_store_n(ring_->cqHead, head, __ATOMIC_RELEASE);
+        --inFlight_;
+
+        if (result > 0 && (size_t)result < buffer->pending)
+        {
+            // Short write: queue the rest
+            buffer->offset  += result;
+            buffer->pending -= result;
+            queue(buffer);
+            continue;
+        }
+        if (result <= 0)
+            failed_ = true;
+        release(buffer);
+    }
+#else
+    (void)wait;
+#endif
+}
+
+//! @param  data    Data to append to the current record
+//!
+//! @return     false if the record is larger than a buffer or a write has failed
+
+bool BulkWriter::Stream::write(std::string_view data)
+{
+    if (!buffer_)
+    {
+        buffer_      = writer_.acquire();
+        recordStart_ = 0;
+    }
+
+    bool ok = true;
+    if (buffer_->size + data.size() > buffer_->capacity)
+    {
+        // Submit the completed records and move the start of the current record to a new buffer. The start is copied aside
+        // first so that a stream never holds more than one buffer.
+        size_t partial = buffer_->size - recordStart_;
+        if (partial + data.size() > buffer_->capacity)
+            return false;
+
+        carry_.assign(buffer_->data + recordStart_, partial);
+        buffer_->size = recordStart_;
+        ok            = writer_.submit(buffer_);
+        buffer_       = writer_.acquire();
+        memcpy(buffer_->data, carry_.data(), partial);
+        buffer_->size = partial;
+        recordStart_  = 0;
+    }
+
+    memcpy(buffer_->data + buffer_->size, data.data(), data.size());
+    buffer_->size += data.size();
+    return ok;
+}
+
+//! @return     false if a write has failed
+
+bool BulkWriter::Stream::flush()
+{
+    if (!buffer_)
+        return true;
+
+    bool ok      = writer_.submit(buffer_);
+    buffer_      = nullptr;
+    recordStart_ = 0;
+    return ok;
+}
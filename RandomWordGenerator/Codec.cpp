@@ -0,0 +1,414 @@
+#include "Codec.h"
+
+#include "Generator.h"
+
+#include <algorithm>
+#include <atomic>
+#include <istream>
+#include <ostream>
+#include <thread>
+
+// The coder is a byte-wise range asymmetric numeral system (rANS) coder. It codes the same integer CDFs that an arithmetic
+// coder would, but its state fits in 32 bits and decoding a symbol needs no division.
+
+namespace
+{
+    char constexpr     MAGIC[4]  = { 'R', 'W', 'G', 'C' };
+    uint32_t constexpr VERSION   = 1;
+    uint32_t constexpr STATE_MIN = 1u << 23;    // Lower bound of the normalized coder state
+    size_t constexpr   MAX_WORD  = 1 << 16;     // Longest word accepted by the decoder
+    size_t constexpr   CONTEXT_COUNT =
+        (RandomWordGenerator::ALPHABET_SIZE + 1) * (RandomWordGenerator::ALPHABET_SIZE + 1) * (RandomWordGenerator::ALPHABET_SIZE + 1);
+
+    size_t toIndex(char c)
+    {
+        return (c >= 'a' && c <= 'z') ? (size_t)(c - 'a') : RandomWordGenerator::TERMINATOR;
+    }
+
+    void writeU32(std::ostream & s, uint32_t v)
+    {
+        char bytes[4] = { (char)v, (char)(v >> 8), (char)(v >> 16), (char)(v >> 24) };
+        s.write(bytes, sizeof(bytes));
+    }
+
+    bool readU32(std::istream & s, uint32_t & v)
+    {
+        unsigned char bytes[4];
+        if (!s.read((char *)bytes, sizeof(bytes)))
+            return false;
+        v = (uint32_t)bytes[0] | ((uint32_t)bytes[1] << 8) | ((uint32_t)bytes[2] << 16) | ((uint32_t)bytes[3] << 24);
+        return true;
+    }
+
+    void writeU64(std::ostream & s, uint64_t v)
+    {
+        writeU32(s, (uint32_t)v);
+        writeU32(s, (uint32_t)(v >> 32));
+    }
+
+    bool readU64(std::istream & s, uint64_t & v)
+    {
+        uint32_t lo;
+        uint32_t hi;
+        if (!readU32(s, lo) || !readU32(s, hi))
+            return false;
+        v = ((uint64_t)hi << 32) | lo;
+        return true;
+    }
+
+    struct Block
+    {
+        uint32_t                 count;
+        std::vector<uint8_t>     payload;
+        std::vector<std::string> words;
+        bool                     ok;
+    };
+}
+
+//! @param  generator   Source of the character probabilities. Every character is given a non-zero probability in every
+//!                     context so that any word made of characters in the alphabet can be coded.
+
+RandomWordCodec::RandomWordCodec(RandomWordGenerator const & generator)
+    : cumulative_(CONTEXT_COUNT * (SYMBOL_COUNT + 1))
+{
+    uint32_t constexpr AVAILABLE = TOTAL - SYMBOL_COUNT;
+
+    for (size_t i = 0; i < RandomWordGenerator::ALPHABET_SIZE + 1; ++i)
+    {
+        for (size_t j = 0; j < RandomWordGenerator::ALPHABET_SIZE + 1; ++j)
+        {
+            for (size_t k = 0; k < RandomWordGenerator::ALPHABET_SIZE + 1; ++k)
+            {
+                float const * cdf = generator.cdf(i, j, k);
+
+                // Every symbol gets at least 1, and the rest is distributed in proportion to the probabilities
+                uint32_t frequencies[SYMBOL_COUNT];
+                float    previous = 0.0f;
+                for (size_t m = 0; m < RandomWordGenerator::ALPHABET_SIZE + 1; ++m)
+                {
+                    float p        = std::max(cdf[m] - previous, 0.0f);
+                    frequencies[m] = 1 + (uint32_t)(p * AVAILABLE);
+                    previous       = cdf[m];
+                }
+                frequencies[ESCAPE] = 1;
+
+                // Give the rounding error to the most likely symbol
+                uint32_t sum     = 0;
+                size_t   largest = 0;
+                for (size_t m = 0; m < SYMBOL_COUNT; ++m)
+                {
+                    sum += frequencies[m];
+                    if (frequencies[m] > frequencies[largest])
+                        largest = m;
+                }
+                frequencies[largest] = frequencies[largest] + TOTAL - sum;
+
+                uint32_t * c = &cumulative_[((i * (RandomWordGenerator::ALPHABET_SIZE + 1) + j) * (RandomWordGenerator::ALPHABET_SIZE + 1) + k) * (SYMBOL_COUNT + 1)];
+                c[0] = 0;
+                for (size_t m = 0; m < SYMBOL_COUNT; ++m)
+                {
+                    c[m + 1] = c[m] + frequencies[m];
+                }
+            }
+        }
+    }
+
+    // FNV-1a
+    checksum_ = 0xcbf29ce484222325ull;
+    for (uint32_t c : cumulative_)
+    {
+        for (int b = 0; b < 32; b += 8)
+        {
+            checksum_ ^= (c >> b) & 0xff;
+            checksum_ *= 0x100000001b3ull;
+        }
+    }
+}
+
+//! @param  words       Words to encode
+//! @param  payload     Receives the coded data
+
+void RandomWordCodec::encodeBlock(std::vector<std::string> const & words, std::vector<uint8_t> & payload) const
+{
+    std::vector<Symbol> symbols;
+    for (auto const & word : words)
+    {
+        addWord(word, symbols);
+    }
+
+    // rANS codes in reverse, so the output is built backwards and then reversed.
+    payload.clear();
+    uint32_t x = STATE_MIN;
+    for (auto s = symbols.rbegin(); s != symbols.rend(); ++s)
+    {
+        uint32_t xMax = ((STATE_MIN >> SCALE_BITS) << 8) * s->frequency;
+        while (x >= xMax)
+        {
+            payload.push_back((uint8_t)x);
+            x >>= 8;
+        }
+        x = ((x / s->frequency) << SCALE_BITS) + (x % s->frequency) + s->start;
+    }
+    payload.push_back((uint8_t)(x >> 24));
+    payload.push_back((uint8_t)(x >> 16));
+    payload.push_back((uint8_t)(x >> 8));
+    payload.push_back((uint8_t)x);
+    std::reverse(payload.begin(), payload.end());
+}
+
+//! @param  payload     Coded data
+//! @param  size        Size of the coded data
+//! @param  count       Number of words in the block
+//! @param  words       Receives the decoded words
+//!
+//! @return     false if the data is corrupt
+
+bool RandomWordCodec::decodeBlock(uint8_t const * payload, size_t size, size_t count, std::vector<std::string> & words) const
+{
+    if (size < 4)
+        return false;
+
+    uint8_t const * p   = payload + 4;
+    uint8_t const * end = payload + size;
+    uint32_t        x   = (uint32_t)payload[0] | ((uint32_t)payload[1] << 8) | ((uint32_t)payload[2] << 16) | ((uint32_t)payload[3] << 24);
+
+    auto advance = [&](uint32_t start, uint32_t frequency) {
+        x = frequency * (x >> SCALE_BITS) + (x & (TOTAL - 1)) - start;
+        while (x < STATE_MIN)
+        {
+            if (p == end)
+                return false;
+            x = (x << 8) | *p++;
+        }
+        return true;
+    };
+
+    auto decodeUniformByte = [&](uint8_t & byte) {
+        byte = (uint8_t)((x & (TOTAL - 1)) >> 8);
+        return advance((uint32_t)byte << 8, 256);
+    };
+
+    for (size_t n = 0; n < count; ++n)
+    {
+        std::string word;
+        size_t      i0 = RandomWordGenerator::TERMINATOR;
+        size_t      i1 = RandomWordGenerator::TERMINATOR;
+        size_t      i2 = RandomWordGenerator::TERMINATOR;
+
+        while (true)
+        {
+            uint32_t const * c    = row(i0, i1, i2);
+            uint32_t         slot = x & (TOTAL - 1);
+            size_t           s    = std::upper_bound(c + 1, c + SYMBOL_COUNT + 1, slot) - (c + 1);
+            if (!advance(c[s], c[s + 1] - c[s]))
+                return false;
+
+            if (s == RandomWordGenerator::TERMINATOR)
+                break;
+
+            if (s == ESCAPE)
+            {
+                if (!word.empty())
+                    return false;
+
+                // The length is a base-128 varint followed by the raw bytes
+                size_t  length = 0;
+                int     shift  = 0;
+                uint8_t byte;
+                do
+                {
+                    if (!decodeUniformByte(byte) || shift > 28)
+                        return false;
+                    length |= (size_t)(byte & 0x7f) << shift;
+                    shift  += 7;
+                } while (byte & 0x80);
+
+                if (length > MAX_WORD)
+                    return false;
+                word.resize(length);
+                for (size_t m = 0; m < length; ++m)
+                {
+                    if (!decodeUniformByte(byte))
+                        return false;
+                    word[m] = (char)byte;
+                }
+                break;
+            }
+
+            if (word.size() >= MAX_WORD)
+                return false;
+            word += (char)('a' + s);
+            i0    = i1;
+            i1    = i2;
+            i2    = s;
+        }
+
+        words.push_back(std::move(word));
+    }
+
+    return x == STATE_MIN && p == end;
+}
+
+//! The stream consists of a header followed by blocks, each with its word count, its payload size, and its payload.
+//!
+//! @param  in          Words to encode, one per line
+//! @param  out         Receives the coded stream
+//! @param  blockSize   Number of words in each block
+//!
+//! @return     false if the output could not be written
+
+bool RandomWordCodec::encode(std::istream & in, std::ostream & out, size_t blockSize /*= DEFAULT_BLOCK_SIZE*/) const
+{
+    out.write(MAGIC, sizeof(MAGIC));
+    writeU32(out, VERSION);
+    writeU64(out, checksum_);
+
+    std::vector<std::string> words;
+    std::vector<uint8_t>     payload;
+    std::string              line;
+    while (true)
+    {
+        bool more = (bool)std::getline(in, line);
+        if (more)
+            words.push_back(line);
+
+        if (words.size() == blockSize || (!more && !words.empty()))
+        {
+            encodeBlock(words, payload);
+            writeU32(out, (uint32_t)words.size());
+            writeU32(out, (uint32_t)payload.size());
+            out.write((char const *)payload.data(), payload.size());
+            words.clear();
+        }
+
+        if (!more)
+            break;
+    }
+
+    return (bool)out;
+}
+
+//! Blocks are read in groups and each group is decoded in parallel.
+//!
+//! @param  in              Coded stream
+//! @param  out             Receives the words, one per line
+//! @param  threadCount     Number of decoding threads, or 0 to use one per hardware thread
+//!
+//! @return     false if the stream is corrupt or was coded with different tables
+
+bool RandomWordCodec::decode(std::istream & in, std::ostream & out, unsigned threadCount /*= 0*/) const
+{
+    char     magic[sizeof(MAGIC)];
+    uint32_t version;
+    uint64_t checksum;
+    if (!in.read(magic, sizeof(magic)) || !std::equal(magic, magic + sizeof(magic), MAGIC))
+        return false;
+    if (!readU32(in, version) || version != VERSION || !readU64(in, checksum) || checksum != checksum_)
+        return false;
+
+    if (threadCount == 0)
+        threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+
+    std::vector<Block> blocks(threadCount * 4);
+    bool               more = true;
+    while (more)
+    {
+        // Read a group of blocks
+        size_t n = 0;
+        while (n < blocks.size())
+        {
+            uint32_t size;
+            if (!readU32(in, blocks[n].count))
+            {
+                more = false;
+                break;
+            }
+            if (!readU32(in, size))
+                return false;
+            blocks[n].payload.resize(size);
+            if (!in.read((char *)blocks[n].payload.data(), size))
+                return false;
+            ++n;
+        }
+
+        // Decode them in parallel
+        std::atomic<size_t>      next(0);
+        std::vector<std::thread> workers;
+        for (unsigned t = 0; t < std::min<size_t>(threadCount, n); ++t)
+        {
+            workers.emplace_back([&] {
+                for (size_t i = next++; i < n; i = next++)
+                {
+                    Block & b = blocks[i];
+                    b.words.clear();
+                    b.ok = decodeBlock(b.payload.data(), b.payload.size(), b.count, b.words);
+                }
+            });
+        }
+        for (auto & worker : workers)
+        {
+            worker.join();
+        }
+
+        // Write them in order
+        for (size_t i = 0; i < n; ++i)
+        {
+            if (!blocks[i].ok)
+                return false;
+            for (auto const & word : blocks[i].words)
+            {
+                out << word << '\n';
+            }
+        }
+    }
+
+    return (bool)out;
+}
+
+uint32_t const * RandomWordCodec::row(size_t i0, size_t i1, size_t i2) const
+{
+    return &cumulative_[((i0 * (RandomWordGenerator::ALPHABET_SIZE + 1) + i1) * (RandomWordGenerator::ALPHABET_SIZE + 1) + i2) * (SYMBOL_COUNT + 1)];
+}
+
+void RandomWordCodec::addWord(std::string const & word, std::vector<Symbol> & symbols) const
+{
+    size_t i0 = RandomWordGenerator::TERMINATOR;
+    size_t i1 = RandomWordGenerator::TERMINATOR;
+    size_t i2 = RandomWordGenerator::TERMINATOR;
+
+    bool escaped = std::any_of(word.begin(), word.end(), [](char c) { return toIndex(c) == RandomWordGenerator::TERMINATOR; });
+    if (escaped)
+    {
+        uint32_t const * c = row(i0, i1, i2);
+        symbols.push_back({ c[ESCAPE], c[ESCAPE + 1] - c[ESCAPE] });
+
+        size_t length = word.size();
+        do
+        {
+            uint8_t byte = (uint8_t)(length & 0x7f);
+            length     >>= 7;
+            if (length > 0)
+                byte |= 0x80;
+            symbols.push_back({ (uint32_t)byte << 8, 256 });
+        } while (length > 0);
+
+        for (char c : word)
+        {
+            symbols.push_back({ (uint32_t)(uint8_t)c << 8, 256 });
+        }
+        return;
+    }
+
+    for (char ch : word)
+    {
+        size_t           s = toIndex(ch);
+        uint32_t const * c = row(i0, i1, i2);
+        symbols.push_back({ c[s], c[s + 1] - c[s] });
+        i0 = i1;
+        i1 = i2;
+        i2 = s;
+    }
+
+    uint32_t const * c = row(i0, i1, i2);
+    symbols.push_back({ c[RandomWordGenerator::TERMINATOR], c[RandomWordGenerator::TERMINATOR + 1] - c[RandomWordGenerator::TERMINATOR] });
+}
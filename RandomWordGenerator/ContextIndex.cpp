@@ -0,0 +1,154 @@
+#include "ContextIndex.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    double constexpr   LOAD_FACTOR         = 0.97;  // Number of keys per position
+    double constexpr   AVERAGE_BUCKET_SIZE = 4.0;   // Average number of keys per bucket, which sets the size of the pilots
+    int constexpr      MAX_ATTEMPTS        = 16;    // Number of seeds tried before giving up
+    uint32_t constexpr PILOT_COUNT         = 65536;
+}
+
+//! @param  keys    Keys in the set
+//!
+//! @return     false if the keys are not distinct or the index could not be built
+
+bool ContextIndex::build(std::vector<uint64_t> const & keys)
+{
+    size_t n = keys.size();
+
+    std::vector<uint64_t> sorted(keys);
+    std::sort(sorted.begin(), sorted.end());
+    if (std::adjacent_find(sorted.begin(), sorted.end()) != sorted.end())
+        return false;
+
+    size_             = n;
+    tableSize_        = std::max(n, (size_t)std::ceil((double)n / LOAD_FACTOR));
+    bucketCount_      = std::max<size_t>(2, (size_t)std::ceil((double)n / AVERAGE_BUCKET_SIZE));
+    denseBucketCount_ = std::max<size_t>(1, bucketCount_ * 3 / 10);
+    pilots_.assign(bucketCount_, 0);
+    remap_.assign(tableSize_ - n, 0);
+    fingerprints_.assign(n, 0);
+    if (n == 0)
+        return true;
+
+    std::vector<std::pair<uint32_t, uint64_t>> entries(n);     // Bucket and hash of each key
+    std::vector<uint32_t>                      bucketStarts(bucketCount_ + 1);
+    std::vector<uint32_t>                      order(bucketCount_);
+    std::vector<bool>                          taken(tableSize_);
+    std::vector<size_t>                        placed;
+
+    uint64_t seedState = 0x3c6ef372fe94f82bull;
+    for (int attempt = 0; attempt < MAX_ATTEMPTS; ++attempt)
+    {
+        seedState += 0x9e3779b97f4a7c15ull;
+        seed_      = WordFingerprint::mix(seedState);
+
+        // Group the keys by bucket. The hashes of distinct keys are distinct, since the hash is a bijection.
+        for (size_t i = 0; i < n; ++i)
+        {
+            uint64_t hash = hashKey(keys[i]);
+            entries[i]    = { (uint32_t)bucket(hash), hash };
+        }
+        std::sort(entries.begin(), entries.end());
+
+        std::fill(bucketStarts.begin(), bucketStarts.end(), 0);
+        for (auto const & entry : entries)
+        {
+            ++bucketStarts[entry.first + 1];
+        }
+        for (size_t b = 0; b < bucketCount_; ++b)
+        {
+            bucketStarts[b + 1] += bucketStarts[b];
+        }
+
+        // Place the largest buckets first, while the table has the most room
+        for (uint32_t b = 0; b < bucketCount_; ++b)
+        {
+            order[b] = b;
+        }
+        std::stable_sort(order.begin(), order.end(), [&bucketStarts] (uint32_t a, uint32_t b) {
+            return bucketStarts[a + 1] - bucketStarts[a] > bucketStarts[b + 1] - bucketStarts[b];
+        });
+
+        std::fill(taken.begin(), taken.end(), false);
+        std::fill(pilots_.begin(), pilots_.end(), 0);
+        bool built = true;
+        for (uint32_t b : order)
+        {
+            uint32_t begin = bucketStarts[b];
+            uint32_t end   = bucketStarts[b + 1];
+            if (begin == end)
+                break;
+
+            // Find a pilot that moves every key of the bucket to a free position
+            bool found = false;
+            for (uint32_t pilot = 0; pilot < PILOT_COUNT && !found; ++pilot)
+            {
+                placed.clear();
+                found = true;
+                for (uint32_t i = begin; i < end; ++i)
+                {
+                    size_t p = place(entries[i].second, (uint16_t)pilot);
+                    if (taken[p])
+                    {
+                        found = false;
+                        break;
+                    }
+                    taken[p] = true;
+                    placed.push_back(p);
+                }
+                if (found)
+                {
+                    pilots_[b] = (uint16_t)pilot;
+                }
+                else
+                {
+                    for (size_t p : placed)
+                    {
+                        taken[p] = false;
+                    }
+                }
+            }
+            if (!found)
+            {
+                built = false;
+                break;
+            }
+        }
+        if (!built)
+            continue;
+
+        // Move the keys placed beyond the last row to the rows left free
+        size_t free = 0;
+        for (size_t p = n; p < tableSize_; ++p)
+        {
+            if (taken[p])
+            {
+                while (taken[free])
+                {
+                    ++free;
+                }
+                remap_[p - n] = (uint32_t)free++;
+            }
+        }
+
+        for (auto const & entry : entries)
+        {
+            fingerprints_[position(entry.second)] = fingerprint(entry.second);
+        }
+        return true;
+    }
+
+    size_ = 0;
+    return false;
+}
+
+//! @return     The number of bytes used by the pilots, the remap table, and the fingerprints
+
+size_t ContextIndex::memorySize() const
+{
+    return pilots_.size() * sizeof(uint16_t) + remap_.size() * sizeof(uint32_t) + fingerprints_.size() * sizeof(uint8_t);
+}
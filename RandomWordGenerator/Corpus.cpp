@@ -0,0 +1,41 @@
+#include "Corpus.h"
+
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+
+//! @param  filename    Name of a distribution file. Each line contains a name, its frequency, the cumulative frequency, and
+//!                     its rank.
+//!
+//! @return     true if the file was loaded
+
+bool RandomWordCorpus::load(char const * filename)
+{
+    std::ifstream file(filename);
+    if (!file.is_open())
+        return false;
+
+    while (!file.eof())
+    {
+        std::string name;
+        float       frequency;
+        float       cumulative;
+        int         rank;
+
+        file >> name >> frequency >> cumulative >> rank;
+        if (!file.eof())
+            add(std::move(name), frequency);
+    }
+
+    return true;
+}
+
+//! @param  word        Word to add
+//! @param  frequency   Relative overall occurrence frequency of the word
+
+void RandomWordCorpus::add(std::string word, float frequency /*= 1.0f*/)
+{
+    std::transform(word.begin(), word.end(), word.begin(), ::tolower);
+    words_.push_back(std::move(word));
+    frequencies_.push_back(frequency);
+}
@@ -1,17 +1,27 @@
 #include "Factory.h"
 
+#include "Corpus.h"
 #include "Generator.h"
+#include "SparseGenerator.h"
 
+#include <cmath>
 #include <iostream>
 #include <numeric>
 
 static std::string const ALPHABET = "abcdefghijklmnopqrstuvwxyz";
 
+// The table is renormalized when the weight of new observations reaches this value, leaving plenty of range in a float for
+// the accumulated frequencies
+static float constexpr RENORMALIZATION_THRESHOLD = 1e20f;
+
+static size_t constexpr ROW_COUNT = (RandomWordGenerator::ALPHABET_SIZE + 1) * (RandomWordGenerator::ALPHABET_SIZE + 1) * (RandomWordGenerator::ALPHABET_SIZE + 1);
+
 RandomWordGeneratorFactory::RandomWordGeneratorFactory()
     : frequencies_(new (float[RandomWordGenerator::ALPHABET_SIZE + 1][RandomWordGenerator::ALPHABET_SIZE + 1][RandomWordGenerator::ALPHABET_SIZE + 1][RandomWordGenerator::ALPHABET_SIZE + 1]))
     , cdfs_(new (float[RandomWordGenerator::ALPHABET_SIZE + 1][RandomWordGenerator::ALPHABET_SIZE + 1][RandomWordGenerator::ALPHABET_SIZE + 1][RandomWordGenerator::ALPHABET_SIZE + 1]))
 {
     memset(frequencies_, 0, sizeof(*frequencies_)*(RandomWordGenerator::ALPHABET_SIZE+1));
+    isDirty_.resize(ROW_COUNT, false);
 }
 
 //! @return     pointer to the created RandomWordGenerator, or 0 if error
@@ -26,6 +36,47 @@ std::shared_ptr<RandomWordGenerator> RandomWordGeneratorFactory::create()
     return std::make_shared<RandomWordGenerator>(cdfs_);
 }
 
+//! @return     pointer to the created SparseGenerator
+//!
+//! @note       This function finalizes the the factory, like create().
+
+std::shared_ptr<SparseGenerator> RandomWordGeneratorFactory::createSparse()
+{
+    if (!finalized_)
+        finalize();
+
+    return std::make_shared<SparseGenerator>(&cdfs_[0][0][0][0]);
+}
+
+//! @param  generator   A generator created by this factory and updated only by this function
+//!
+//! Only the rows that changed are recomputed and replaced, so updating a generator after a few words have been analyzed is
+//! much faster than creating a new one.
+
+void RandomWordGeneratorFactory::update(RandomWordGenerator & generator)
+{
+    std::vector<uint32_t> rows;
+    if (allDirty_)
+    {
+        rows.resize(ROW_COUNT);
+        std::iota(rows.begin(), rows.end(), 0u);
+    }
+    else
+    {
+        rows = dirtyRows_;
+    }
+
+    finalize();
+
+    for (uint32_t row : rows)
+    {
+        size_t i = row / ((RandomWordGenerator::ALPHABET_SIZE + 1) * (RandomWordGenerator::ALPHABET_SIZE + 1));
+        size_t j = row / (RandomWordGenerator::ALPHABET_SIZE + 1) % (RandomWordGenerator::ALPHABET_SIZE + 1);
+        size_t k = row % (RandomWordGenerator::ALPHABET_SIZE + 1);
+        generator.setCdf(i, j, k, cdfs_[i][j][k]);
+    }
+}
+
 //! @param  word    Word to process
 //! @param  factor  Relative overall occurrence frequency of the word. 1.0f means it occurs with average frequency.
 //!
@@ -49,11 +100,14 @@ bool RandomWordGeneratorFactory::analyzeWord(char const * word, float factor /*=
     size_t c1 = RandomWordGenerator::TERMINATOR;
     size_t c2 = RandomWordGenerator::TERMINATOR;
 
+    float weighted = factor * weight_;
+
     for (size_t i = 0; i < length; ++i)
     {
         size_t c = ALPHABET.find(word[i]);
 
-        frequencies_[c0][c1][c2][c] += factor;
+        frequencies_[c0][c1][c2][c] += weighted;
+        markDirty(c0, c1, c2);
 
         c0 = c1;
         c1 = c2;
@@ -61,7 +115,8 @@ bool RandomWordGeneratorFactory::analyzeWord(char const * word, float factor /*=
     }
 
     // Add the distribution for the terminator
-    frequencies_[c0][c1][c2][RandomWordGenerator::TERMINATOR] += factor;
+    frequencies_[c0][c1][c2][RandomWordGenerator::TERMINATOR] += weighted;
+    markDirty(c0, c1, c2);
 
     finalized_ = false;
     return true;
@@ -115,47 +170,206 @@ bool RandomWordGeneratorFactory::analyzeText(char const * text, float factor /*=
     return true;
 }
 
+//! @param  corpus      Words and frequencies to process
+//! @param  unweighted  If true, every word is counted once, which suits lists of distinct names better than weighting by
+//!                     frequency
+//!
+//! @return     true if every word in the corpus was successfully processed
+
+bool RandomWordGeneratorFactory::analyzeCorpus(RandomWordCorpus const & corpus, bool unweighted /* = false*/)
+{
+    bool ok = true;
+    for (size_t i = 0; i < corpus.size(); ++i)
+    {
+        ok = analyzeWord(corpus.word(i).c_str(), unweighted ? 1.0f : corpus.frequency(i)) && ok;
+    }
+    return ok;
+}
+
+//! @param  filename    Name of a distribution file
+//! @param  unweighted  If true, every word is counted once
+//!
+//! @return     The trained generator, or nullptr if the file cannot be loaded
+//!
+//! The tools train their models with this function, so that models trained from the same file with the same options have
+//! the same checksum, which model deltas and the tuning cache rely on.
+
+std::shared_ptr<RandomWordGenerator> RandomWordGeneratorFactory::train(char const * filename, bool unweighted /* = false*/)
+{
+    RandomWordCorpus corpus;
+    if (!corpus.load(filename))
+        return std::shared_ptr<RandomWordGenerator>();
+
+    RandomWordGeneratorFactory factory;
+    factory.analyzeCorpus(corpus, unweighted);
+    return factory.create();
+}
+
+//! @param  factor  Factor applied to the frequencies of all the words analyzed so far
+//!
+//! This is used to make old observations fade out when words are analyzed from a stream. Rather than multiplying every
+//! frequency, later observations are weighted by the reciprocal of the accumulated factor.
+
+void RandomWordGeneratorFactory::decay(float factor)
+{
+    if (factor >= 1.0f || factor <= 0.0f)
+        return;
+
+    weight_ /= factor;
+    if (weight_ >= RENORMALIZATION_THRESHOLD)
+        renormalize();
+
+    // The relative frequencies in each row are unchanged, unless they are mixed with the absolute smoothing and pruning
+    // values
+    if (smoothing_ > 0.0f || pruningThreshold_ > 0.0f)
+        markAllDirty();
+}
+
+//! @param  smoothing   Pseudo-count added to each character of a context that appears in the analyzed words. Contexts that
+//!                     never appear are not smoothed and still always choose the terminator.
+
+void RandomWordGeneratorFactory::setSmoothing(float smoothing)
+{
+    smoothing_ = smoothing;
+    markAllDirty();
+}
+
+//! @param  threshold   Transitions with an accumulated frequency less than this value are treated as never occurring.
+
+void RandomWordGeneratorFactory::setPruningThreshold(float threshold)
+{
+    pruningThreshold_ = threshold;
+    markAllDirty();
+}
+
+//! @param  bits    Number of bits of precision kept in each CDF value, or 0 to keep full precision
+
+void RandomWordGeneratorFactory::setQuantization(int bits)
+{
+    quantization_ = bits;
+    markAllDirty();
+}
+
 void RandomWordGeneratorFactory::finalize()
 {
-    // The table (when finalized) contains the cumulative distribution functions for all the letters.
+    // The table (when finalized) contains the cumulative distribution functions for all the letters. Only the rows that
+    // changed since the last time are recomputed.
 
-    for (size_t i = 0; i < RandomWordGenerator::ALPHABET_SIZE + 1; ++i)
+    if (allDirty_)
     {
-        for (size_t j = 0; j < RandomWordGenerator::ALPHABET_SIZE + 1; ++j)
+        for (size_t i = 0; i < RandomWordGenerator::ALPHABET_SIZE + 1; ++i)
         {
-            for (size_t k = 0; k < RandomWordGenerator::ALPHABET_SIZE + 1; ++k)
+            for (size_t j = 0; j < RandomWordGenerator::ALPHABET_SIZE + 1; ++j)
             {
-                float * dist = frequencies_[i][j][k];
-                float * cdf  = cdfs_[i][j][k];
-
-                // Compute the CDF for the final character
-
-                float sum = std::accumulate(dist, dist + RandomWordGenerator::ALPHABET_SIZE + 1, 0.0f);
-                if (sum > 0.0f)
-                {
-                    float c = 0.0f;
-                    for (size_t m = 0; m < RandomWordGenerator::ALPHABET_SIZE + 1; ++m)
-                    {
-                        c     += dist[m];
-                        cdf[m] = c / sum;
-                    }
-                }
-                else
+                for (size_t k = 0; k < RandomWordGenerator::ALPHABET_SIZE + 1; ++k)
                 {
-                    // This never occurs, so just make a CDF that always chooses the terminator
-                    for (size_t m = 0; m < RandomWordGenerator::ALPHABET_SIZE; ++m)
-                    {
-                        cdf[m] = 0.0f;
-                    }
-                    cdf[RandomWordGenerator::ALPHABET_SIZE] = 1.0f;
+                    finalizeRow(i, j, k);
                 }
             }
         }
     }
+    else
+    {
+        for (uint32_t row : dirtyRows_)
+        {
+            size_t i = row / ((RandomWordGenerator::ALPHABET_SIZE + 1) * (RandomWordGenerator::ALPHABET_SIZE + 1));
+            size_t j = row / (RandomWordGenerator::ALPHABET_SIZE + 1) % (RandomWordGenerator::ALPHABET_SIZE + 1);
+            size_t k = row % (RandomWordGenerator::ALPHABET_SIZE + 1);
+            finalizeRow(i, j, k);
+        }
+    }
 
+    for (uint32_t row : dirtyRows_)
+    {
+        isDirty_[row] = false;
+    }
+    dirtyRows_.clear();
+    allDirty_  = false;
     finalized_ = true;
 }
 
+void RandomWordGeneratorFactory::finalizeRow(size_t i, size_t j, size_t k)
+{
+    float * cdf = cdfs_[i][j][k];
+    float   dist[RandomWordGenerator::ALPHABET_SIZE + 1];
+
+    // Prune rare transitions. The stored frequencies are scaled back to their decayed values first.
+
+    float scale = 1.0f / weight_;
+    for (size_t m = 0; m < RandomWordGenerator::ALPHABET_SIZE + 1; ++m)
+    {
+        float f = frequencies_[i][j][k][m] * scale;
+        dist[m] = (f >= pruningThreshold_) ? f : 0.0f;
+    }
+
+    // Compute the CDF for the final character
+
+    float sum = std::accumulate(dist, dist + RandomWordGenerator::ALPHABET_SIZE + 1, 0.0f);
+    if (sum > 0.0f)
+    {
+        sum += smoothing_ * (RandomWordGenerator::ALPHABET_SIZE + 1);
+
+        float c = 0.0f;
+        for (size_t m = 0; m < RandomWordGenerator::ALPHABET_SIZE + 1; ++m)
+        {
+            c     += dist[m] + smoothing_;
+            cdf[m] = c / sum;
+        }
+
+        if (quantization_ > 0)
+        {
+            float q = std::ldexp(1.0f, quantization_);
+            for (size_t m = 0; m < RandomWordGenerator::ALPHABET_SIZE; ++m)
+            {
+                cdf[m] = std::round(cdf[m] * q) / q;
+            }
+        }
+        cdf[RandomWordGenerator::ALPHABET_SIZE] = 1.0f;
+    }
+    else
+    {
+        // This never occurs, so just make a CDF that always chooses the terminator
+        for (size_t m = 0; m < RandomWordGenerator::ALPHABET_SIZE; ++m)
+        {
+            cdf[m] = 0.0f;
+        }
+        cdf[RandomWordGenerator::ALPHABET_SIZE] = 1.0f;
+    }
+}
+
+void RandomWordGeneratorFactory::markDirty(size_t i, size_t j, size_t k)
+{
+    finalized_ = false;
+    if (allDirty_)
+        return;
+
+    uint32_t row = (uint32_t)((i * (RandomWordGenerator::ALPHABET_SIZE + 1) + j) * (RandomWordGenerator::ALPHABET_SIZE + 1) + k);
+    if (!isDirty_[row])
+    {
+        isDirty_[row] = true;
+        dirtyRows_.push_back(row);
+    }
+}
+
+void RandomWordGeneratorFactory::markAllDirty()
+{
+    finalized_ = false;
+    allDirty_  = true;
+}
+
+// Applies the accumulated decay to the stored frequencies, so new observations are again added with a weight of 1. The
+// decayed frequencies are unchanged, so no row becomes dirty.
+void RandomWordGeneratorFactory::renormalize()
+{
+    float   scale = 1.0f / weight_;
+    float * f     = &frequencies_[0][0][0][0];
+    for (size_t n = 0; n < ROW_COUNT * (RandomWordGenerator::ALPHABET_SIZE + 1); ++n)
+    {
+        f[n] *= scale;
+    }
+    weight_ = 1.0f;
+}
+
 std::ostream & operator <<(std::ostream & s, RandomWordGeneratorFactory const & f)
 {
     for (int i = 0; i < RandomWordGenerator::ALPHABET_SIZE + 1; ++i)
@@ -166,7 +380,7 @@ std::ostream & operator <<(std::ostream & s, RandomWordGeneratorFactory const &
             {
                 for (int m = 0; m < RandomWordGenerator::ALPHABET_SIZE + 1; ++m)
                 {
-                    s << f.frequencies_[i][j][k][m] << ' ';
+                    s << f.frequencies_[i][j][k][m] / f.weight_ << ' ';
                 }
             }
         }
@@ -1,12 +1,19 @@
 #include "Generator.h"
 
+#include "Fingerprint.h"
+#include "ModelView.h"
+
 #include <algorithm>
+#include <cmath>
+#include <limits>
+#include <ostream>
 #include <Misc/Assertx.h>
 
 RandomWordGenerator::RandomWordGenerator()
     : cdfs_(new (float[ALPHABET_SIZE + 1][ALPHABET_SIZE + 1][ALPHABET_SIZE + 1][ALPHABET_SIZE+1]))
 {
     memset(cdfs_, 0, sizeof(*cdfs_)*(ALPHABET_SIZE + 1));
+    updateChecksum();
 }
 
 //! @param    table    Distribution function table
@@ -23,6 +30,7 @@ RandomWordGenerator::RandomWordGenerator(Table table)
     : cdfs_(new (float[ALPHABET_SIZE + 1][ALPHABET_SIZE + 1][ALPHABET_SIZE + 1][ALPHABET_SIZE + 1]))
 {
     memcpy(cdfs_, table, sizeof(*cdfs_)*(ALPHABET_SIZE + 1));
+    updateChecksum();
 }
 
 RandomWordGenerator::~RandomWordGenerator()
@@ -37,6 +45,41 @@ RandomWordGenerator::~RandomWordGenerator()
 //! @return        The generated word
 
 std::string RandomWordGenerator::operator ()(std::minstd_rand & rng, size_t maxLength /* = 0*/)
+{
+    return (*this)(nullptr, 0, rng, maxLength);
+}
+
+//! @param  uniforms    Uniforms in [0, 1) used to generate the characters, in order
+//! @param  count       Number of uniforms
+//! @param  rng         Entropy source for the characters beyond count
+//! @param  maxLength   Maximum number of characters in the word. If max_length == 0, then the length is unbounded.
+//!
+//! @return        The generated word
+
+std::string RandomWordGenerator::operator ()(float const * uniforms, size_t count, std::minstd_rand & rng, size_t maxLength /* = 0*/)
+{
+    return generate(uniforms, count, rng, maxLength, nullptr);
+}
+
+//! @param  rng             Entropy source
+//! @param  fingerprint     Receives each character of the word as it is generated
+//! @param  maxLength       Maximum number of characters in the word. If max_length == 0, then the length is unbounded.
+//!
+//! @return        The generated word
+//!
+//! @note       The characters are appended to the fingerprint, so several words can be fingerprinted together, such as the
+//!             parts of a full name with the spaces between them appended by the caller.
+
+std::string RandomWordGenerator::operator ()(std::minstd_rand & rng, WordFingerprint & fingerprint, size_t maxLength /* = 0*/)
+{
+    return generate(nullptr, 0, rng, maxLength, &fingerprint);
+}
+
+std::string RandomWordGenerator::generate(float const *      uniforms,
+                                          size_t             count,
+                                          std::minstd_rand & rng,
+                                          size_t             maxLength,
+                                          WordFingerprint *  fingerprint)
 {
     std::string word;
     size_t      i0     = ALPHABET_SIZE;
@@ -49,7 +92,8 @@ std::string RandomWordGenerator::operator ()(std::minstd_rand & rng, size_t maxL
     while (word.size() <= maxLength || maxLength == 0)
     {
         // Generate the next character
-        char c = nextCharacter(rng, i0, i1, i2);
+        float u = (word.size() < count) ? uniforms[word.size()] : randomFloat_(rng);
+        char  c = nextCharacter(u, i0, i1, i2);
 
         // If the word is terminated then we are done
         if (c == 0)
@@ -57,6 +101,8 @@ std::string RandomWordGenerator::operator ()(std::minstd_rand & rng, size_t maxL
 
         // Append the character to the word
         word += c;
+        if (fingerprint)
+            fingerprint->append(c);
 
         // Keep track of the last three characters
         i0 = i1;
@@ -67,14 +113,118 @@ std::string RandomWordGenerator::operator ()(std::minstd_rand & rng, size_t maxL
     return word;
 }
 
-char RandomWordGenerator::nextCharacter(std::minstd_rand & rng, size_t i0, size_t i1, size_t i2)
+//! @param  word    Word to evaluate
+//!
+//! @return     The log probability of the word (including its terminator), or -infinity if the word cannot be generated
+
+double RandomWordGenerator::logProbability(std::string_view word) const
+{
+    ProbabilityProduct probability;
+    size_t             i0 = TERMINATOR;
+    size_t             i1 = TERMINATOR;
+    size_t             i2 = TERMINATOR;
+
+    for (char c : word)
+    {
+        size_t i = toIndex(c);
+        if (i == TERMINATOR || !probability.multiply(cdfs_[i0][i1][i2], i))
+            return -std::numeric_limits<double>::infinity();
+
+        i0 = i1;
+        i1 = i2;
+        i2 = i;
+    }
+
+    return probability.logProbability(cdfs_[i0][i1][i2]);
+}
+
+//! @param  cdf     CDF of the context following the last character of the word
+//!
+//! @return     The log probability of the word (including its terminator), or -infinity if the word cannot end there
+
+double RandomWordGenerator::ProbabilityProduct::logProbability(float const * cdf) const
+{
+    float p = cdf[TERMINATOR] - cdf[TERMINATOR - 1];
+    if (p <= 0.0f)
+        return -std::numeric_limits<double>::infinity();
+    return std::log(product * p) + scale;
+}
+
+char RandomWordGenerator::nextCharacter(float u, size_t i0, size_t i1, size_t i2) const
 {
     auto begin = &cdfs_[i0][i1][i2][0];
     auto end   = &cdfs_[i0][i1][i2 + 1][0];
-    auto i     = std::upper_bound(begin, end, randomFloat_(rng));
+    auto i     = std::upper_bound(begin, end, u);
     return (i != end) ? toCharacter(std::distance(begin, i)) : 0;
 }
 
+//! @param  i0      Index of the first character of the sequence
+//! @param  i1      Index of the second character of the sequence
+//! @param  i2      Index of the third character of the sequence
+//! @param  cdf     New distribution function of the character following the sequence
+//!
+//! @warning    The generator must not be in use by another thread.
+
+void RandomWordGenerator::setCdf(size_t i0, size_t i1, size_t i2, float const cdf[ALPHABET_SIZE + 1])
+{
+    checksum_ -= rowChecksum(i0, i1, i2);
+    memcpy(cdfs_[i0][i1][i2], cdf, sizeof(cdfs_[i0][i1][i2]));
+    checksum_ += rowChecksum(i0, i1, i2);
+}
+
+// Returns a hash of a row of the table and its position
+uint64_t RandomWordGenerator::rowChecksum(size_t i0, size_t i1, size_t i2) const
+{
+    uint64_t h = 0xcbf29ce484222325ull;
+    for (float p : cdfs_[i0][i1][i2])
+    {
+        uint32_t bits;
+        memcpy(&bits, &p, sizeof(bits));
+        h = (h ^ bits) * 0x100000001b3ull;
+    }
+    h ^= ((i0 * (ALPHABET_SIZE + 1) + i1) * (ALPHABET_SIZE + 1) + i2) * 0x9e3779b97f4a7c15ull;
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    return h;
+}
+
+void RandomWordGenerator::updateChecksum()
+{
+    checksum_ = 0;
+    for (size_t i0 = 0; i0 < ALPHABET_SIZE + 1; ++i0)
+    {
+        for (size_t i1 = 0; i1 < ALPHABET_SIZE + 1; ++i1)
+        {
+            for (size_t i2 = 0; i2 < ALPHABET_SIZE + 1; ++i2)
+            {
+                checksum_ += rowChecksum(i0, i1, i2);
+            }
+        }
+    }
+}
+
+//! @param  out     Receives the image
+//!
+//! @return     false if the image could not be written
+
+bool RandomWordGenerator::writeImage(std::ostream & out) const
+{
+    static_assert(ModelView::SYMBOL_COUNT == ALPHABET_SIZE + 1, "ModelView must have the same alphabet");
+
+    uint32_t header[ModelView::HEADER_SIZE / sizeof(uint32_t)] = {
+        ModelView::magic(),
+        ModelView::VERSION,
+        (uint32_t)ModelView::SYMBOL_COUNT,
+        (uint32_t)ModelView::ORDER,
+        (uint32_t)checksum_,
+        (uint32_t)(checksum_ >> 32)
+    };
+    out.write(reinterpret_cast<char const *>(header), sizeof(header));
+    out.write(reinterpret_cast<char const *>(cdfs_), sizeof(*cdfs_) * (ALPHABET_SIZE + 1));
+    return (bool)out;
+}
+
 std::ostream & operator <<(std::ostream & s, RandomWordGenerator const & g)
 {
     for (int i = 0; i < RandomWordGenerator::ALPHABET_SIZE + 1; ++i)
@@ -105,12 +255,16 @@ std::istream & operator >>(std::istream & s, RandomWordGenerator & g)
                     float p;
                     s >> p;
                     if (s.eof() || p < 0.0f || p > 1.0f)
+                    {
+                        g.updateChecksum();
                         return s;
+                    }
                     g.cdfs_[i][j][k][m] = p;
                 }
             }
         }
     }
+    g.updateChecksum();
     return s;
 }
 
@@ -0,0 +1,241 @@
+#include "HandleDeriver.h"
+
+#include "Fingerprint.h"
+
+#include <algorithm>
+
+namespace
+{
+    // Returns the entry of a key in an open-addressing table of entries of the given size, or the empty entry where it
+    // would be. The key must not be 0, and the table must not be full.
+    size_t find(std::vector<uint64_t> const & table, size_t entrySize, uint64_t key)
+    {
+        size_t mask = table.size() / entrySize - 1;
+        for (size_t i = (size_t)(key >> 7) & mask;; i = (i + 1) & mask)
+        {
+            uint64_t k = table[i * entrySize];
+            if (k == key || k == 0)
+                return i;
+        }
+    }
+
+    // Doubles the size of an open-addressing table when it is half full
+    void reserve(std::vector<uint64_t> & table, size_t entrySize, size_t count)
+    {
+        if ((count + 1) * 2 * entrySize <= table.size())
+            return;
+
+        std::vector<uint64_t> grown(std::max<size_t>(table.size() * 2, 64 * entrySize), 0);
+        for (size_t i = 0; i < table.size(); i += entrySize)
+        {
+            if (table[i] != 0)
+            {
+                size_t j = find(grown, entrySize, table[i]);
+                std::copy(table.begin() + i, table.begin() + i + entrySize, grown.begin() + j * entrySize);
+            }
+        }
+        table.swap(grown);
+    }
+
+    // Appends a number in decimal
+    void appendNumber(std::string & s, uint64_t n)
+    {
+        char   digits[20];
+        size_t count = 0;
+        do
+        {
+            digits[count++] = (char)('0' + n % 10);
+            n /= 10;
+        } while (n > 0);
+        while (count > 0)
+        {
+            s += digits[--count];
+        }
+    }
+}
+
+//! @param  maxLength   Maximum length of a handle, or 0 for no limit
+HandleDeriver::HandleDeriver(size_t maxLength)
+    : maxLength_(maxLength)
+    , shards_(new Shard[SHARD_COUNT])
+{
+}
+
+HandleDeriver::~HandleDeriver() = default;
+
+//! @param  pattern     Text containing any of the placeholders {first}, {last}, {f} and {l}
+//!
+//! @return     true if the template was added
+//!
+//! @warning    Templates must be added before handles are derived.
+bool HandleDeriver::addTemplate(std::string_view pattern)
+{
+    Template t;
+    while (!pattern.empty())
+    {
+        size_t open = pattern.find('{');
+        if (open > 0)
+        {
+            t.parts.push_back(Part::TEXT);
+            t.text.emplace_back(pattern.substr(0, open));
+            if (open == std::string_view::npos)
+                break;
+        }
+
+        size_t close = pattern.find('}', open);
+        if (close == std::string_view::npos)
+            return false;
+        std::string_view placeholder = pattern.substr(open + 1, close - open - 1);
+        if (placeholder == "first")
+            t.parts.push_back(Part::FIRST);
+        else if (placeholder == "last")
+            t.parts.push_back(Part::LAST);
+        else if (placeholder == "f")
+            t.parts.push_back(Part::FIRST_INITIAL);
+        else if (placeholder == "l")
+            t.parts.push_back(Part::LAST_INITIAL);
+        else
+            return false;
+        pattern.remove_prefix(close + 1);
+    }
+    if (t.parts.empty())
+        return false;
+
+    templates_.push_back(std::move(t));
+    return true;
+}
+
+//! @param  name    A first and last name separated by a space
+//! @param  handle  The unique handle, or empty if none is left
+//!
+//! @return     false if every handle that fits in the maximum length has been issued
+//!
+//! @note       The handle is empty if no templates were added.
+bool HandleDeriver::derive(std::string_view name, std::string & handle)
+{
+    handle.clear();
+    if (templates_.empty())
+        return true;
+
+    size_t           space = name.find(' ');
+    std::string_view first = name.substr(0, space);
+    std::string_view last  = (space != std::string_view::npos) ? name.substr(space + 1) : std::string_view();
+
+    // Use the first template whose handle has not been issued
+
+    for (auto const & t : templates_)
+    {
+        expand(t, first, last, handle);
+        if (claim(WordFingerprint::of(handle)))
+        {
+            ++count_;
+            return true;
+        }
+    }
+
+    // Otherwise, follow the handle of the first template with the next number not tried for it. A number is only skipped if
+    // a handle from another prefix or template already took it.
+
+    expand(templates_[0], first, last, handle);
+    uint64_t prefix = WordFingerprint::of(handle);
+    size_t   length = handle.size();
+    while (true)
+    {
+        uint64_t n = nextNumber(prefix);
+        handle.resize(length);
+        appendNumber(handle, n);
+        if (maxLength_ > 0 && handle.size() > maxLength_)
+        {
+            // The number alone is too long, and so is every later one
+            size_t digits = handle.size() - length;
+            if (digits > maxLength_)
+            {
+                handle.clear();
+                return false;
+            }
+            handle.erase(maxLength_ - digits, handle.size() - maxLength_);
+        }
+        if (claim(WordFingerprint::of(handle)))
+        {
+            ++count_;
+            return true;
+        }
+    }
+}
+
+void HandleDeriver::clear()
+{
+    for (size_t i = 0; i < SHARD_COUNT; ++i)
+    {
+        std::lock_guard<std::mutex> lock(shards_[i].mutex);
+        shards_[i].issued.clear();
+        shards_[i].issuedCount = 0;
+        shards_[i].counters.clear();
+        shards_[i].counterCount = 0;
+    }
+    count_ = 0;
+}
+
+// Sets handle to the template applied to a name, shortened to the maximum length
+void HandleDeriver::expand(Template const & t, std::string_view first, std::string_view last, std::string & handle) const
+{
+    handle.clear();
+    size_t text = 0;
+    for (Part part : t.parts)
+    {
+        switch (part)
+        {
+            case Part::TEXT:
+                handle += t.text[text++];
+                break;
+            case Part::FIRST:
+                handle += first;
+                break;
+            case Part::LAST:
+                handle += last;
+                break;
+            case Part::FIRST_INITIAL:
+                handle += first.substr(0, 1);
+                break;
+            case Part::LAST_INITIAL:
+                handle += last.substr(0, 1);
+                break;
+        }
+    }
+    if (maxLength_ > 0 && handle.size() > maxLength_)
+        handle.resize(maxLength_);
+}
+
+// Marks a handle as issued. Returns false if it already was.
+bool HandleDeriver::claim(uint64_t fingerprint)
+{
+    fingerprint = (fingerprint != 0) ? fingerprint : 1;
+
+    Shard &                     shard = shards_[fingerprint % SHARD_COUNT];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    reserve(shard.issued, 1, shard.issuedCount);
+    size_t i = find(shard.issued, 1, fingerprint);
+    if (shard.issued[i] != 0)
+        return false;
+    shard.issued[i] = fingerprint;
+    ++shard.issuedCount;
+    return true;
+}
+
+// Returns the next number to try after a prefix, starting at 1
+uint64_t HandleDeriver::nextNumber(uint64_t prefix)
+{
+    // The fingerprint is mixed again so that the counters and the issued handles are not in the same shards
+    prefix = (prefix != 0) ? prefix : 1;
+
+    Shard &                     shard = shards_[WordFingerprint::mix(prefix) % SHARD_COUNT];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    reserve(shard.counters, 2, shard.counterCount);
+    size_t i = find(shard.counters, 2, prefix);
+    if (shard.counters[i * 2] == 0)
+    {
+        shard.counters[i * 2] = prefix;
+        ++shard.counterCount;
+    }
+    return ++shard.counters[i * 2 + 1];
+}
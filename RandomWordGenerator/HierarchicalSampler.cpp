@@ -0,0 +1,99 @@
+#include "HierarchicalSampler.h"
+
+#include "Generator.h"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace
+{
+    // Fills the unused entries of the tables. It is greater than any u, so they are never counted.
+    float constexpr PADDING = 2.0f;
+
+    // Returns the number of values in a group that are not greater than u. The loop has no branches, so it is vectorized.
+    size_t countNotGreater(float const * group, float u)
+    {
+        size_t n = 0;
+        for (size_t k = 0; k < HierarchicalSampler::GROUP_SIZE; ++k)
+        {
+            n += (group[k] <= u) ? 1 : 0;
+        }
+        return n;
+    }
+}
+
+//! @param  cdfs            Rows of CDF values, one after the other
+//! @param  rowCount        Number of rows
+//! @param  symbolCount     Number of values in each row
+HierarchicalSampler::HierarchicalSampler(float const * cdfs, size_t rowCount, size_t symbolCount)
+    : rowCount_(rowCount)
+    , symbolCount_(symbolCount)
+    , groupCount_((symbolCount + GROUP_SIZE - 1) / GROUP_SIZE)
+    , boundsSize_((groupCount_ + GROUP_SIZE - 1) / GROUP_SIZE * GROUP_SIZE)
+    , rowStride_(boundsSize_ + groupCount_ * GROUP_SIZE)
+{
+    // Every row starts on a cache line, since the stride is a whole number of groups
+    memory_.reset(new float[rowCount_ * rowStride_ + GROUP_SIZE]);
+    uintptr_t address = reinterpret_cast<uintptr_t>(memory_.get());
+    size_t    skip    = (size_t)((GROUP_SIZE * sizeof(float) - address % (GROUP_SIZE * sizeof(float))) % (GROUP_SIZE * sizeof(float)));
+    table_ = memory_.get() + skip / sizeof(float);
+    std::fill(table_, table_ + rowCount_ * rowStride_, PADDING);
+
+    for (size_t r = 0; r < rowCount_; ++r)
+    {
+        float const * cdf    = cdfs + r * symbolCount_;
+        float *       row    = table_ + r * rowStride_;
+        float *       groups = row + boundsSize_;
+        for (size_t g = 0; g < groupCount_; ++g)
+        {
+            size_t end = std::min((g + 1) * GROUP_SIZE, symbolCount_);
+            row[g] = cdf[end - 1];
+            std::copy(cdf + g * GROUP_SIZE, cdf + end, groups + g * GROUP_SIZE);
+        }
+    }
+}
+
+//! @param  generator   Generator whose CDFs are sampled
+HierarchicalSampler::HierarchicalSampler(RandomWordGenerator const & generator)
+    : HierarchicalSampler(generator.cdf(0, 0, 0),
+                          (RandomWordGenerator::ALPHABET_SIZE + 1) * (RandomWordGenerator::ALPHABET_SIZE + 1) * (RandomWordGenerator::ALPHABET_SIZE + 1),
+                          RandomWordGenerator::ALPHABET_SIZE + 1)
+{
+}
+
+//! @param  row     Index of the row
+//! @param  u       A value in [0, 1)
+//!
+//! @return     The index of the sampled symbol
+size_t HierarchicalSampler::sample(size_t row, float u) const
+{
+    float const * bounds = table_ + row * rowStride_;
+
+    size_t g = (boundsSize_ == GROUP_SIZE) ? countNotGreater(bounds, u) : (size_t)(std::upper_bound(bounds, bounds + groupCount_, u) - bounds);
+    if (g >= groupCount_)
+        return symbolCount_;
+    return g * GROUP_SIZE + countNotGreater(bounds + boundsSize_ + g * GROUP_SIZE, u);
+}
+
+//! @param  rng         Entropy source
+//! @param  maxLength   Maximum number of characters in the word, or 0 if the length is unbounded
+//!
+//! @return     The generated word
+std::string HierarchicalSampler::operator ()(std::minstd_rand & rng, size_t maxLength /* = 0*/) const
+{
+    static size_t constexpr N = RandomWordGenerator::ALPHABET_SIZE + 1;
+
+    std::uniform_real_distribution<float> randomFloat(0.0f, 1.0f);
+    std::string                           word;
+    size_t                                context = RandomWordGenerator::TERMINATOR * (N * N + N + 1);
+
+    while (word.size() <= maxLength || maxLength == 0)
+    {
+        size_t i = sample(context, randomFloat(rng));
+        if (i >= RandomWordGenerator::ALPHABET_SIZE)
+            break;
+        word += (char)('a' + i);
+        context = context % (N * N) * N + i;
+    }
+    return word;
+}
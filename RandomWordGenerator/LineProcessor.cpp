@@ -0,0 +1,169 @@
+#include "LineProcessor.h"
+
+#include "BoundedQueue.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    struct Block
+    {
+        std::vector<char>  input;
+        size_t             size = 0;        // Amount of input, ending at a line break unless it is the end of the input
+        std::string        output;
+        uint64_t           sequence = 0;
+        unsigned long long lines    = 0;
+    };
+}
+
+//! @param  threadCount     Number of worker threads, or 0 for all cores
+//! @param  blockSize       Size of the blocks read from the input
+LineProcessor::LineProcessor(unsigned threadCount, size_t blockSize)
+    : threadCount_(threadCount ? threadCount : std::max(std::thread::hardware_concurrency(), 1u))
+    , blockSize_(std::max<size_t>(blockSize, 4096))
+{
+}
+
+//! @param  in      Input
+//! @param  out     Output
+//! @param  f       Function called with each line
+//!
+//! @return     false if the input cannot be read or the output cannot be written
+bool LineProcessor::run(std::FILE * in, std::FILE * out, Function const & f)
+{
+    // Each worker may hold a block, and the reader and writer may hold up to two each, so blocks are never waited for
+    // longer than it takes to write one.
+    size_t const       blockCount = 2 * (size_t)threadCount_ + 4;
+    std::vector<Block> blocks(blockCount);
+    BoundedQueue<Block *> free(blockCount);
+    BoundedQueue<Block *> work(blockCount);
+    for (auto & block : blocks)
+    {
+        block.input.resize(blockSize_);
+        free.push(&block);
+    }
+
+    // Finished blocks are stored by sequence number. At most blockCount blocks are in use, so slots are never reused
+    // before they are written.
+    std::vector<Block *>    done(blockCount, nullptr);
+    std::mutex              doneMutex;
+    std::condition_variable doneReady;
+    uint64_t                blocksRead = UINT64_MAX;    // Set when the whole input has been read
+    bool                    readError  = false;
+
+    std::thread reader([&] {
+        std::vector<char> carry;
+        uint64_t          sequence = 0;
+        bool              ok       = true;
+        while (true)
+        {
+            Block * block = free.pop();
+            if (block->input.size() < carry.size() + blockSize_)
+                block->input.resize(carry.size() + blockSize_);
+            std::copy(carry.begin(), carry.end(), block->input.begin());
+            size_t n    = std::fread(block->input.data() + carry.size(), 1, block->input.size() - carry.size(), in);
+            size_t size = carry.size() + n;
+            if (n == 0)
+            {
+                ok = !std::ferror(in);
+                if (size == 0)
+                {
+                    free.push(block);
+                    break;
+                }
+            }
+
+            // End the block at its last line break, and carry the rest into the next one. A line longer than a block is
+            // carried until its end is found.
+            size_t end = size;
+            if (n > 0)
+            {
+                while (end > 0 && block->input[end - 1] != '\n')
+                {
+                    --end;
+                }
+            }
+            carry.assign(block->input.begin() + end, block->input.begin() + size);
+            if (end == 0)
+            {
+                free.push(block);
+                continue;
+            }
+
+            block->size     = end;
+            block->sequence = sequence++;
+            work.push(block);
+        }
+
+        for (unsigned t = 0; t < threadCount_; ++t)
+        {
+            work.push(nullptr);
+        }
+        std::lock_guard<std::mutex> lock(doneMutex);
+        blocksRead = sequence;
+        readError  = !ok;
+        doneReady.notify_one();
+    });
+
+    std::atomic<unsigned long long> lines(0);
+    std::vector<std::thread>        workers;
+    for (unsigned t = 0; t < threadCount_; ++t)
+    {
+        workers.emplace_back([&, t] {
+            unsigned long long count = 0;
+            while (Block * block = work.pop())
+            {
+                block->output.clear();
+                char const * p    = block->input.data();
+                char const * last = p + block->size;
+                while (p < last)
+                {
+                    char const * eol = static_cast<char const *>(memchr(p, '\n', last - p));
+                    char const * e   = eol ? eol : last;
+                    size_t       n   = (e > p && e[-1] == '\r') ? e - p - 1 : e - p;
+                    f(std::string_view(p, n), block->output, t);
+                    ++count;
+                    p = e + 1;
+                }
+
+                std::lock_guard<std::mutex> lock(doneMutex);
+                done[block->sequence % blockCount] = block;
+                doneReady.notify_one();
+            }
+            lines += count;
+        });
+    }
+
+    // Write the blocks in order
+
+    bool ok = true;
+    for (uint64_t next = 0;; ++next)
+    {
+        Block * block;
+        {
+            std::unique_lock<std::mutex> lock(doneMutex);
+            doneReady.wait(lock, [&] { return done[next % blockCount] != nullptr || next == blocksRead; });
+            if (next == blocksRead)
+                break;
+            block = done[next % blockCount];
+            done[next % blockCount] = nullptr;
+        }
+        if (ok && !block->output.empty())
+            ok = std::fwrite(block->output.data(), 1, block->output.size(), out) == block->output.size();
+        free.push(block);
+    }
+
+    reader.join();
+    for (auto & worker : workers)
+    {
+        worker.join();
+    }
+    lineCount_ = lines;
+    return ok && !readError && std::fflush(out) == 0;
+}
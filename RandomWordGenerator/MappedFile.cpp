@@ -0,0 +1,104 @@
+#include "MappedFile.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+//! @param  filename    Name of the file to map
+//!
+//! @return     true if the file was mapped
+//!
+//! @note       An empty file is mapped successfully and has no data.
+
+bool MappedFile::open(char const * filename)
+{
+    close();
+
+#if defined(_WIN32)
+    HANDLE file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size))
+    {
+        CloseHandle(file);
+        return false;
+    }
+    file_ = file;
+    if (size.QuadPart == 0)
+        return true;
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping)
+    {
+        close();
+        return false;
+    }
+    mapping_ = mapping;
+
+    void * view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!view)
+    {
+        close();
+        return false;
+    }
+    data_ = static_cast<uint8_t const *>(view);
+    size_ = (size_t)size.QuadPart;
+#else
+    int fd = ::open(filename, O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat status;
+    if (fstat(fd, &status) != 0)
+    {
+        ::close(fd);
+        return false;
+    }
+
+    if (status.st_size > 0)
+    {
+        void * view = mmap(nullptr, (size_t)status.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        if (view == MAP_FAILED)
+        {
+            ::close(fd);
+            return false;
+        }
+        data_ = static_cast<uint8_t const *>(view);
+        size_ = (size_t)status.st_size;
+    }
+    ::close(fd);
+#endif
+
+    return true;
+}
+
+void MappedFile::close()
+{
+#if defined(_WIN32)
+    if (data_)
+        UnmapViewOfFile(data_);
+    if (mapping_)
+        CloseHandle(mapping_);
+    if (file_)
+        CloseHandle(file_);
+    mapping_ = nullptr;
+    file_    = nullptr;
+#else
+    if (data_)
+        munmap(const_cast<uint8_t *>(data_), size_);
+#endif
+    data_ = nullptr;
+    size_ = 0;
+}
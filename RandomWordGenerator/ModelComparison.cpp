@@ -0,0 +1,176 @@
+#include "ModelComparison.h"
+
+#include "Generator.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <thread>
+
+namespace
+{
+    static size_t constexpr N           = RandomWordGenerator::ALPHABET_SIZE + 1;
+    static size_t constexpr CONTEXTS    = N * N * N;
+    static size_t constexpr START       = CONTEXTS - 1;
+    static size_t constexpr MAX_LENGTH  = 256;      // Words longer than this are ignored in the occupancy
+    static double constexpr MIN_MASS    = 1e-12;    // Propagation stops when less probability than this is left
+    static size_t constexpr CHUNK_SIZE  = 256;      // Number of contexts compared by a thread at a time
+
+    // Returns the probabilities of the characters following a context
+    void probabilities(RandomWordGenerator const & generator, size_t context, float p[N])
+    {
+        float const * cdf      = generator.cdf(context / (N * N), context / N % N, context % N);
+        float         previous = 0.0f;
+        for (size_t c = 0; c < N; ++c)
+        {
+            p[c]     = std::max(cdf[c] - previous, 0.0f);
+            previous = std::max(previous, cdf[c]);
+        }
+    }
+
+    // Returns the expected number of occurrences of each context in a word
+    std::vector<double> occupancy(RandomWordGenerator const & generator)
+    {
+        // The probability of being in each context after t characters is propagated one character at a time. Only the
+        // contexts with some probability are visited.
+
+        std::vector<double> result(CONTEXTS, 0.0);
+        std::vector<double> current(CONTEXTS, 0.0);
+        std::vector<double> next(CONTEXTS, 0.0);
+        std::vector<size_t> active  = { START };
+        std::vector<size_t> touched;
+        current[START] = 1.0;
+
+        for (size_t t = 0; t < MAX_LENGTH && !active.empty(); ++t)
+        {
+            double mass = 0.0;
+            touched.clear();
+            for (size_t context : active)
+            {
+                double visits = current[context];
+                current[context] = 0.0;
+                result[context] += visits;
+
+                float p[N];
+                probabilities(generator, context, p);
+                size_t base = context % (N * N) * N;
+                for (size_t c = 0; c < RandomWordGenerator::ALPHABET_SIZE; ++c)
+                {
+                    if (p[c] > 0.0f)
+                    {
+                        if (next[base + c] == 0.0)
+                            touched.push_back(base + c);
+                        next[base + c] += visits * p[c];
+                        mass           += visits * p[c];
+                    }
+                }
+            }
+            std::swap(current, next);
+            active.swap(touched);
+            if (mass < MIN_MASS)
+                break;
+        }
+        return result;
+    }
+
+    // Returns the KL divergence of q from p, and the JS divergence between them
+    void divergence(float const p[N], float const q[N], double & kl, double & js)
+    {
+        kl = 0.0;
+        js = 0.0;
+        for (size_t c = 0; c < N; ++c)
+        {
+            double pc = p[c];
+            double qc = q[c];
+            double m  = 0.5 * (pc + qc);
+            if (pc > 0.0)
+            {
+                kl += (qc > 0.0) ? pc * std::log(pc / qc) : std::numeric_limits<double>::infinity();
+                js += 0.5 * pc * std::log(pc / m);
+            }
+            if (qc > 0.0)
+                js += 0.5 * qc * std::log(qc / m);
+        }
+        kl = std::max(kl, 0.0);
+        js = std::max(js, 0.0);
+    }
+}
+
+//! @param  context     Index of the context
+//!
+//! @return     The three characters of the context
+std::string ModelComparison::contextName(size_t context)
+{
+    size_t      indexes[3] = { context / (N * N), context / N % N, context % N };
+    std::string name;
+    for (size_t i : indexes)
+    {
+        name += (i < RandomWordGenerator::ALPHABET_SIZE) ? (char)('a' + i) : '^';
+    }
+    return name;
+}
+
+//! @param  base            Base model
+//! @param  candidate       Candidate model
+//! @param  threadCount     Number of threads, or 0 for all cores
+//!
+//! @return     The comparison
+ModelComparison compareModels(RandomWordGenerator const & base, RandomWordGenerator const & candidate, unsigned threadCount)
+{
+    if (threadCount == 0)
+        threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+
+    std::vector<double> visits = occupancy(base);
+
+    ModelComparison result;
+    for (size_t context = 0; context < CONTEXTS; ++context)
+    {
+        if (visits[context] > 0.0)
+            result.contexts.push_back({ context, visits[context], 0.0, 0.0 });
+    }
+
+    // The contexts are compared in chunks claimed by the threads
+
+    std::atomic<size_t>      nextChunk(0);
+    std::vector<std::thread> threads;
+    for (unsigned t = 0; t < threadCount; ++t)
+    {
+        threads.emplace_back([&] {
+            size_t first;
+            while ((first = nextChunk.fetch_add(CHUNK_SIZE)) < result.contexts.size())
+            {
+                size_t last = std::min(first + CHUNK_SIZE, result.contexts.size());
+                for (size_t i = first; i < last; ++i)
+                {
+                    ContextDivergence & d = result.contexts[i];
+                    float               p[N];
+                    float               q[N];
+                    probabilities(base, d.context, p);
+                    probabilities(candidate, d.context, q);
+                    divergence(p, q, d.kl, d.js);
+                }
+            }
+        });
+    }
+    for (auto & thread : threads)
+    {
+        thread.join();
+    }
+
+    result.wordKl         = 0.0;
+    result.weightedJs     = 0.0;
+    result.expectedLength = 0.0;
+    result.unsupported    = 0;
+    for (auto const & d : result.contexts)
+    {
+        result.wordKl         += d.occupancy * d.kl;
+        result.weightedJs     += d.occupancy * d.js;
+        result.expectedLength += d.occupancy;
+        if (std::isinf(d.kl))
+            ++result.unsupported;
+    }
+    if (result.expectedLength > 0.0)
+        result.weightedJs /= result.expectedLength;
+    return result;
+}
@@ -0,0 +1,136 @@
+#include "ModelDelta.h"
+
+#include <cstring>
+#include <istream>
+#include <ostream>
+
+namespace
+{
+    char constexpr     MAGIC[4] = { 'R', 'W', 'G', 'D' };
+    uint32_t constexpr VERSION  = 1;
+
+    // Layout (little-endian):
+    //
+    //      0   magic
+    //      4   version
+    //      8   base checksum
+    //      16  target checksum
+    //      24  number of rows
+    //      28  rows: context (u32), followed by the CDF (27 floats)
+
+    template <typename T>
+    void store(std::ostream & s, T v)
+    {
+        s.write(reinterpret_cast<char const *>(&v), sizeof(v));
+    }
+
+    template <typename T>
+    bool load(std::istream & s, T & v)
+    {
+        return static_cast<bool>(s.read(reinterpret_cast<char *>(&v), sizeof(v)));
+    }
+}
+
+//! @param  base    Model the delta applies to
+//! @param  target  Model produced by the delta
+//!
+//! @return     The delta
+ModelDelta ModelDelta::diff(RandomWordGenerator const & base, RandomWordGenerator const & target)
+{
+    ModelDelta delta;
+    delta.baseChecksum_   = base.checksum();
+    delta.targetChecksum_ = target.checksum();
+    for (uint32_t context = 0; context < N * N * N; ++context)
+    {
+        float const * from = base.cdf(context / (N * N), context / N % N, context % N);
+        float const * to   = target.cdf(context / (N * N), context / N % N, context % N);
+        if (memcmp(from, to, sizeof(Row::cdf)) != 0)
+        {
+            Row row;
+            row.context = context;
+            memcpy(row.cdf, to, sizeof(row.cdf));
+            delta.rows_.push_back(row);
+        }
+    }
+    return delta;
+}
+
+//! @param  out     Stream to write to
+//!
+//! @return     false if the delta cannot be written
+bool ModelDelta::write(std::ostream & out) const
+{
+    out.write(MAGIC, sizeof(MAGIC));
+    store(out, VERSION);
+    store(out, baseChecksum_);
+    store(out, targetChecksum_);
+    store(out, (uint32_t)rows_.size());
+    for (auto const & row : rows_)
+    {
+        store(out, row.context);
+        out.write(reinterpret_cast<char const *>(row.cdf), sizeof(row.cdf));
+    }
+    return static_cast<bool>(out);
+}
+
+//! @param  in      Stream to read from
+//!
+//! @return     false if the data is not a valid delta
+bool ModelDelta::read(std::istream & in)
+{
+    char     magic[4];
+    uint32_t version;
+    uint32_t count;
+    if (!in.read(magic, sizeof(magic)) || memcmp(magic, MAGIC, sizeof(MAGIC)) != 0)
+        return false;
+    if (!load(in, version) || version != VERSION)
+        return false;
+    if (!load(in, baseChecksum_) || !load(in, targetChecksum_) || !load(in, count) || count > N * N * N)
+        return false;
+
+    // A row is rejected unless its context is valid and its CDF is non-decreasing and within [0, 1]
+    rows_.resize(count);
+    for (auto & row : rows_)
+    {
+        if (!load(in, row.context) || row.context >= N * N * N || !in.read(reinterpret_cast<char *>(row.cdf), sizeof(row.cdf)))
+            return false;
+        float previous = 0.0f;
+        for (float p : row.cdf)
+        {
+            if (!(p >= previous && p <= 1.0f))
+                return false;
+            previous = p;
+        }
+    }
+    return true;
+}
+
+//! @param  model   Model to update
+//!
+//! @return     false if the delta does not apply to the model or does not produce the target model
+bool ModelDelta::apply(RandomWordGenerator & model) const
+{
+    if (model.checksum() != baseChecksum_)
+        return false;
+
+    // The rows are kept so that a delta whose rows are damaged, but still valid, can be undone
+    std::vector<Row> original(rows_.size());
+    for (size_t r = 0; r < rows_.size(); ++r)
+    {
+        uint32_t context = rows_[r].context;
+        original[r].context = context;
+        memcpy(original[r].cdf, model.cdf(context / (N * N), context / N % N, context % N), sizeof(original[r].cdf));
+        model.setCdf(context / (N * N), context / N % N, context % N, rows_[r].cdf);
+    }
+
+    if (model.checksum() != targetChecksum_)
+    {
+        for (size_t r = rows_.size(); r > 0; --r)
+        {
+            Row const & row = original[r - 1];
+            model.setCdf(row.context / (N * N), row.context / N % N, row.context % N, row.cdf);
+        }
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,78 @@
+#include "ModelLoader.h"
+
+#include "Factory.h"
+#include "Generator.h"
+
+#include <algorithm>
+
+//! @param  threadCount     Number of threads, or 0 for the number of cores, up to 4
+ModelLoader::ModelLoader(unsigned threadCount)
+{
+    if (threadCount == 0)
+        threadCount = std::min(std::max(std::thread::hardware_concurrency(), 1u), 4u);
+    for (unsigned t = 0; t < threadCount; ++t)
+    {
+        threads_.emplace_back(&ModelLoader::work, this);
+    }
+}
+
+ModelLoader::~ModelLoader()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+        tasks_.clear();     // Their futures report broken promises
+    }
+    ready_.notify_all();
+    for (auto & thread : threads_)
+    {
+        thread.join();
+    }
+}
+
+//! @param  filename    Name of a distribution file
+//!
+//! @return     A future for the model, which is nullptr if the file cannot be loaded
+ModelLoader::Future ModelLoader::load(std::string const & filename)
+{
+    return load(filename, [filename] { return RandomWordGeneratorFactory::train(filename.c_str()); });
+}
+
+//! @param  key     Identifies the model. If a model with the same key has already been requested, its future is returned.
+//! @param  create  Creates the model, or returns nullptr if it cannot
+//!
+//! @return     A future for the model
+ModelLoader::Future ModelLoader::load(std::string const & key, std::function<Model()> create)
+{
+    Future future;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto                        i = loads_.find(key);
+        if (i != loads_.end())
+            return i->second;
+
+        std::packaged_task<Model()> task(std::move(create));
+        future = task.get_future().share();
+        tasks_.push_back(std::move(task));
+        loads_.emplace(key, future);
+    }
+    ready_.notify_one();
+    return future;
+}
+
+void ModelLoader::work()
+{
+    while (true)
+    {
+        std::packaged_task<Model()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            ready_.wait(lock, [this] { return stopping_ || !tasks_.empty(); });
+            if (tasks_.empty())
+                return;
+            task = std::move(tasks_.front());
+            tasks_.pop_front();
+        }
+        task();
+    }
+}
@@ -0,0 +1,181 @@
+#include "NameRecordWriter.h"
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+namespace
+{
+    // PostgreSQL binary COPY: the signature, the flags and the length of the header extension
+    char constexpr POSTGRES_HEADER[] = { 'P', 'G', 'C', 'O', 'P', 'Y', '\n', '\xff', '\r', '\n', '\0', 0, 0, 0, 0, 0, 0, 0, 0 };
+
+    // PostgreSQL binary COPY: a field count of -1
+    char constexpr POSTGRES_TRAILER[] = { '\xff', '\xff' };
+
+    size_t constexpr ID_WIDTH = 12;     // Digits of the ID in FIXED records
+
+    // Stores a value in network byte order
+    template <typename T>
+    void storeBigEndian(char * p, T v)
+    {
+        for (size_t i = 0; i < sizeof(T); ++i)
+        {
+            p[i] = (char)(uint8_t)(v >> (8 * (sizeof(T) - 1 - i)));
+        }
+    }
+
+    // Splits a name with an optional handle into its parts. The name no longer includes the handle.
+    void split(std::string_view & name, std::string_view & first, std::string_view & last, std::string_view & handle)
+    {
+        size_t tab = name.find('\t');
+        handle = (tab != std::string_view::npos) ? name.substr(tab + 1) : std::string_view();
+        name   = name.substr(0, tab);
+
+        size_t space = name.find(' ');
+        first = name.substr(0, space);
+        last  = (space != std::string_view::npos) ? name.substr(space + 1) : std::string_view();
+    }
+}
+
+//! @param  stream      Stream the records are written to
+//! @param  options     Format of the records
+NameRecordWriter::NameRecordWriter(BulkWriter::Stream & stream, Options const & options)
+    : stream_(stream)
+    , options_(options)
+{
+}
+
+//! @return     true if the header was written
+bool NameRecordWriter::begin()
+{
+    bool ok = true;
+    if (options_.format == Format::POSTGRES)
+    {
+        ok = stream_.write(std::string_view(POSTGRES_HEADER, sizeof(POSTGRES_HEADER)));
+        stream_.endRecord();
+    }
+    return ok;
+}
+
+//! @param  id      ID of the record
+//! @param  name    A first and last name separated by a space
+//!
+//! @return     true if the record was written
+bool NameRecordWriter::write(uint64_t id, std::string_view name)
+{
+    std::string_view first;
+    std::string_view last;
+    std::string_view handle;
+    bool             ok = true;
+
+    switch (options_.format)
+    {
+        case Format::TEXT:
+            ok = stream_.write(name) && stream_.put('\n');
+            break;
+
+        case Format::POSTGRES:
+        {
+            // A tuple is the field count, then the length and value of each field
+            char prefix[2 + 4 + 8];
+            storeBigEndian(prefix, (int16_t)(options_.handles ? 5 : 4));
+            storeBigEndian(prefix + 2, (int32_t)8);
+            storeBigEndian(prefix + 6, id);
+            split(name, first, last, handle);
+            ok = stream_.write(std::string_view(prefix, sizeof(prefix))) && writeField(first) && writeField(last) && writeField(name);
+            if (options_.handles)
+                ok = ok && writeField(handle);
+            break;
+        }
+
+        case Format::FIXED:
+        {
+            if (!fits(name, options_))
+                return false;
+            char digits[ID_WIDTH];
+            for (size_t i = ID_WIDTH; i > 0; --i, id /= 10)
+            {
+                digits[i - 1] = (char)('0' + id % 10);
+            }
+            split(name, first, last, handle);
+            ok = stream_.write(std::string_view(digits, ID_WIDTH)) &&
+                 writePadded(first, options_.firstWidth) &&
+                 writePadded(last, options_.lastWidth) &&
+                 writePadded(name, options_.firstWidth + 1 + options_.lastWidth) &&
+                 (!options_.handles || writePadded(handle, options_.handleWidth)) &&
+                 stream_.put('\n');
+            break;
+        }
+    }
+
+    stream_.endRecord();
+    return ok;
+}
+
+//! @return     true if the trailer was written
+bool NameRecordWriter::end()
+{
+    bool ok = true;
+    if (options_.format == Format::POSTGRES)
+    {
+        ok = stream_.write(std::string_view(POSTGRES_TRAILER, sizeof(POSTGRES_TRAILER)));
+        stream_.endRecord();
+    }
+    return ok;
+}
+
+//! @param  name        A first and last name separated by a space
+//! @param  options     Format of the records
+//!
+//! @return     true if the name can be written
+bool NameRecordWriter::fits(std::string_view name, Options const & options)
+{
+    if (options.format != Format::FIXED)
+        return true;
+
+    std::string_view first;
+    std::string_view last;
+    std::string_view handle;
+    split(name, first, last, handle);
+    return first.size() <= options.firstWidth && last.size() <= options.lastWidth && handle.size() <= options.handleWidth;
+}
+
+//! @param  name    Name of a format
+//! @param  format  The format, if it exists
+//!
+//! @return     true if the format exists
+bool NameRecordWriter::parseFormat(char const * name, Format & format)
+{
+    if (strcmp(name, "text") == 0)
+        format = Format::TEXT;
+    else if (strcmp(name, "postgres") == 0)
+        format = Format::POSTGRES;
+    else if (strcmp(name, "fixed") == 0)
+        format = Format::FIXED;
+    else
+        return false;
+    return true;
+}
+
+// Writes a PostgreSQL field: its length and its value
+bool NameRecordWriter::writeField(std::string_view value)
+{
+    char length[4];
+    storeBigEndian(length, (int32_t)value.size());
+    return stream_.write(std::string_view(length, sizeof(length))) && stream_.write(value);
+}
+
+// Writes a value followed by enough spaces to fill the width
+bool NameRecordWriter::writePadded(std::string_view value, size_t width)
+{
+    static std::string const SPACES(64, ' ');
+
+    bool ok = stream_.write(value);
+    for (size_t padding = width - value.size(); ok && padding > 0;)
+    {
+        size_t n = std::min(padding, SPACES.size());
+        ok       = stream_.write(std::string_view(SPACES.data(), n));
+        padding -= n;
+    }
+    return ok;
+}
@@ -0,0 +1,314 @@
+#include "NearDuplicateFilter.h"
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+
+namespace
+{
+    bool isVowel(char c)
+    {
+        return c == 'a' || c == 'e' || c == 'i' || c == 'o' || c == 'u';
+    }
+
+    bool isFrontVowel(char c)
+    {
+        return c == 'e' || c == 'i' || c == 'y';
+    }
+}
+
+//! @param  maxDistance     Words within this many edits of an accepted word are rejected
+NearDuplicateFilter::NearDuplicateFilter(unsigned maxDistance)
+    : maxDistance_(maxDistance)
+    , shards_(new Shard[SHARD_COUNT])
+{
+}
+
+//! @param  word    Word to check
+//!
+//! @return     true if the word is similar to an accepted word
+bool NearDuplicateFilter::rejects(std::string_view word)
+{
+    auto start = std::chrono::steady_clock::now();
+    ++checked_;
+
+    // The key is inserted before the edit distance is checked, so that two words with the same key cannot both pass. If
+    // the word is then rejected, the key is removed again.
+
+    bool        rejected         = false;
+    bool        phoneticRejected = false;
+    std::string key              = phoneticKey(word);
+    if (!insertKey(key))
+    {
+        ++phoneticRejections_;
+        rejected         = true;
+        phoneticRejected = true;
+    }
+    else if (maxDistance_ > 0)
+    {
+        std::vector<uint64_t> variants;
+        deletionVariants(word, variants);
+
+        std::lock_guard<std::mutex> lock(indexMutex_);
+        rejected = findWithin(word, variants);
+        if (!rejected)
+            insertWord(word, variants);
+    }
+    if (rejected && !phoneticRejected)
+    {
+        ++distanceRejections_;
+        eraseKey(key);
+    }
+
+    std::chrono::nanoseconds elapsed = std::chrono::steady_clock::now() - start;
+    nanoseconds_ += (uint64_t)elapsed.count();
+    return rejected;
+}
+
+void NearDuplicateFilter::clear()
+{
+    for (size_t i = 0; i < SHARD_COUNT; ++i)
+    {
+        std::lock_guard<std::mutex> lock(shards_[i].mutex);
+        shards_[i].keys.clear();
+    }
+    std::lock_guard<std::mutex> lock(indexMutex_);
+    words_.clear();
+    index_.clear();
+}
+
+//! @return     The counts of the words checked so far
+NearDuplicateFilter::Statistics NearDuplicateFilter::statistics() const
+{
+    return { checked_, phoneticRejections_, distanceRejections_, (double)nanoseconds_ * 1e-9 };
+}
+
+//! @param  word    A lowercase word
+//!
+//! @return     The phonetic key of the word
+//!
+//! This is a simplified form of Metaphone. Vowels are dropped except at the start, letters that sound alike are mapped to
+//! the same code, silent letters are dropped, and repeated codes are collapsed.
+std::string NearDuplicateFilter::phoneticKey(std::string_view word)
+{
+    std::string letters;
+    for (char c : word)
+    {
+        if (c >= 'a' && c <= 'z')
+            letters += c;
+    }
+
+    // Silent initial letters
+    size_t start = 0;
+    if (letters.size() >= 2)
+    {
+        std::string_view initial(letters.data(), 2);
+        if (initial == "kn" || initial == "gn" || initial == "pn" || initial == "wr" || initial == "ae")
+            start = 1;
+        else if (initial == "wh")
+            letters[1] = 'w', start = 1;
+    }
+    if (!letters.empty() && letters[0] == 'x')
+        letters[0] = 's';
+
+    std::string key;
+    auto        emit = [&key](char code) {
+        if (key.empty() || key.back() != code)
+            key += code;
+    };
+
+    for (size_t i = start; i < letters.size(); ++i)
+    {
+        char c    = letters[i];
+        char next = (i + 1 < letters.size()) ? letters[i + 1] : 0;
+        char prev = (i > start) ? letters[i - 1] : 0;
+
+        if (isVowel(c))
+        {
+            if (i == start)
+                emit('a');
+            continue;
+        }
+
+        switch (c)
+        {
+            case 'b':
+                if (!(prev == 'm' && next == 0))
+                    emit('b');
+                break;
+            case 'c':
+                if (next == 'h')
+                    emit('x'), ++i;
+                else if (isFrontVowel(next))
+                    emit('s');
+                else
+                    emit('k');
+                break;
+            case 'd':
+                emit((next == 'g' && isFrontVowel(i + 2 < letters.size() ? letters[i + 2] : 0)) ? 'j' : 't');
+                break;
+            case 'g':
+                if (next == 'h' && !isVowel(i + 2 < letters.size() ? letters[i + 2] : 0))
+                    ++i;                    // Silent, as in "knight"
+                else if (next == 'n')
+                    ;                       // Silent, as in "sign"
+                else
+                    emit(isFrontVowel(next) ? 'j' : 'k');
+                break;
+            case 'h':
+                if (isVowel(next) && !isVowel(prev))
+                    emit('h');
+                break;
+            case 'k':
+                if (prev != 'c')
+                    emit('k');
+                break;
+            case 'p':
+                if (next == 'h')
+                    emit('f'), ++i;
+                else
+                    emit('p');
+                break;
+            case 'q':
+                emit('k');
+                break;
+            case 's':
+                if (next == 'h')
+                    emit('x'), ++i;
+                else
+                    emit('s');
+                break;
+            case 't':
+                if (next == 'h')
+                    emit('0'), ++i;
+                else
+                    emit('t');
+                break;
+            case 'v':
+                emit('f');
+                break;
+            case 'w':
+            case 'y':
+                if (isVowel(next))
+                    emit(c);
+                break;
+            case 'x':
+                emit('k');
+                key += 's';
+                break;
+            case 'z':
+                emit('s');
+                break;
+            default:
+                emit(c);
+                break;
+        }
+    }
+    return key;
+}
+
+//! @param  a   A word
+//! @param  b   Another word
+//!
+//! @return     The minimum number of insertions, deletions and substitutions turning a into b
+unsigned NearDuplicateFilter::editDistance(std::string_view a, std::string_view b)
+{
+    if (a.size() < b.size())
+        std::swap(a, b);
+
+    // One row of the dynamic programming table, over the shorter word
+    unsigned row[64];
+    std::vector<unsigned> heap;
+    unsigned *            d = row;
+    if (b.size() + 1 > sizeof(row) / sizeof(row[0]))
+    {
+        heap.resize(b.size() + 1);
+        d = heap.data();
+    }
+
+    for (size_t j = 0; j <= b.size(); ++j)
+    {
+        d[j] = (unsigned)j;
+    }
+    for (size_t i = 1; i <= a.size(); ++i)
+    {
+        unsigned diagonal = d[0];
+        d[0] = (unsigned)i;
+        for (size_t j = 1; j <= b.size(); ++j)
+        {
+            unsigned above = d[j];
+            d[j]     = std::min({ above + 1, d[j - 1] + 1, diagonal + (a[i - 1] != b[j - 1] ? 1u : 0u) });
+            diagonal = above;
+        }
+    }
+    return d[b.size()];
+}
+
+bool NearDuplicateFilter::insertKey(std::string const & key)
+{
+    Shard &                     shard = shards_[std::hash<std::string>()(key) % SHARD_COUNT];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    return shard.keys.insert(key).second;
+}
+
+void NearDuplicateFilter::eraseKey(std::string const & key)
+{
+    Shard &                     shard = shards_[std::hash<std::string>()(key) % SHARD_COUNT];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.keys.erase(key);
+}
+
+// Returns the hashes of the word and of every variant of it with up to maxDistance_ letters deleted, without repeats
+void NearDuplicateFilter::deletionVariants(std::string_view word, std::vector<uint64_t> & variants) const
+{
+    std::vector<std::string> level = { std::string(word) };
+    variants.push_back(std::hash<std::string>()(level[0]));
+    for (unsigned d = 0; d < maxDistance_; ++d)
+    {
+        std::vector<std::string> next;
+        for (auto const & w : level)
+        {
+            for (size_t i = 0; i < w.size(); ++i)
+            {
+                // Deleting any letter of a run gives the same variant, so only the first one is deleted
+                if (i > 0 && w[i] == w[i - 1])
+                    continue;
+                std::string v = w.substr(0, i) + w.substr(i + 1);
+                variants.push_back(std::hash<std::string>()(v));
+                next.push_back(std::move(v));
+            }
+        }
+        level = std::move(next);
+    }
+    std::sort(variants.begin(), variants.end());
+    variants.erase(std::unique(variants.begin(), variants.end()), variants.end());
+}
+
+// Returns true if an accepted word is within maxDistance_ of the word. The index must be locked.
+bool NearDuplicateFilter::findWithin(std::string_view word, std::vector<uint64_t> const & variants) const
+{
+    for (uint64_t v : variants)
+    {
+        auto range = index_.equal_range(v);
+        for (auto i = range.first; i != range.second; ++i)
+        {
+            std::string const & candidate = words_[i->second];
+            size_t              longer    = std::max(candidate.size(), word.size());
+            size_t              shorter   = std::min(candidate.size(), word.size());
+            if (longer - shorter <= maxDistance_ && editDistance(word, candidate) <= maxDistance_)
+                return true;
+        }
+    }
+    return false;
+}
+
+// Adds a word to the index. The index must be locked.
+void NearDuplicateFilter::insertWord(std::string_view word, std::vector<uint64_t> const & variants)
+{
+    uint32_t index = (uint32_t)words_.size();
+    words_.emplace_back(word);
+    for (uint64_t v : variants)
+    {
+        index_.emplace(v, index);
+    }
+}
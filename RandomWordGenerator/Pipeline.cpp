@@ -0,0 +1,231 @@
+#include "Pipeline.h"
+
+#include "BoundedQueue.h"
+#include "WordArena.h"
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+struct WordPipeline::Node
+{
+    std::string           name;
+    unsigned              parallelism = 1;
+    Source                source;
+    Stage                 stage;
+    Sink                  sink;
+    std::atomic<uint64_t> batches{ 0 };
+    std::atomic<uint64_t> words{ 0 };
+    std::atomic<uint64_t> busyNanoseconds{ 0 };
+    std::atomic<uint64_t> depthSamples{ 0 };
+    std::atomic<uint64_t> depthSum{ 0 };
+    std::atomic<size_t>   maxDepth{ 0 };
+    size_t                queueCapacity = 0;
+};
+
+namespace
+{
+    using Clock      = std::chrono::steady_clock;
+    using BatchQueue = BoundedQueue<WordArena *>;
+
+    uint64_t nanosecondsSince(Clock::time_point start)
+    {
+        return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+    }
+}
+
+//! @param  queueCapacity   Number of batches that can wait between two stages
+
+WordPipeline::WordPipeline(size_t queueCapacity /*= 16*/)
+    : queueCapacity_(std::max<size_t>(queueCapacity, 1))
+    , stopped_(false)
+{
+    nodes_.push_back(std::make_unique<Node>());
+}
+
+WordPipeline::~WordPipeline() = default;
+
+//! @param  name            Name reported in the metrics
+//! @param  source          Function that fills batches
+//! @param  parallelism     Number of threads calling the function
+
+void WordPipeline::setSource(std::string const & name, Source source, unsigned parallelism /*= 1*/)
+{
+    nodes_[0]->name        = name;
+    nodes_[0]->source      = std::move(source);
+    nodes_[0]->parallelism = std::max(parallelism, 1u);
+}
+
+//! @param  name            Name reported in the metrics
+//! @param  stage           Function that transforms batches
+//! @param  parallelism     Number of threads calling the function
+
+void WordPipeline::addStage(std::string const & name, Stage stage, unsigned parallelism /*= 1*/)
+{
+    auto node         = std::make_unique<Node>();
+    node->name        = name;
+    node->stage       = std::move(stage);
+    node->parallelism = std::max(parallelism, 1u);
+    nodes_.push_back(std::move(node));
+}
+
+//! @param  name            Name reported in the metrics
+//! @param  sink            Function that consumes batches
+//! @param  parallelism     Number of threads calling the function
+
+void WordPipeline::setSink(std::string const & name, Sink sink, unsigned parallelism /*= 1*/)
+{
+    sink_              = std::make_unique<Node>();
+    sink_->name        = name;
+    sink_->sink        = std::move(sink);
+    sink_->parallelism = std::max(parallelism, 1u);
+}
+
+//! @warning    Nothing happens if the source or the sink has not been set.
+
+void WordPipeline::run()
+{
+    if (!nodes_[0]->source || !sink_)
+        return;
+
+    std::vector<Node *> chain;
+    for (auto & node : nodes_)
+    {
+        chain.push_back(node.get());
+    }
+    chain.push_back(sink_.get());
+
+    // Every batch is either in the pool, in a queue, or held by a worker, so this many are enough to keep every queue full
+    unsigned workerCount = 0;
+    for (Node * node : chain)
+    {
+        workerCount += node->parallelism;
+    }
+    size_t                 batchCount = queueCapacity_ * (chain.size() - 1) + workerCount;
+    std::vector<WordArena> batches(batchCount);
+    BatchQueue             pool(batchCount);
+    for (auto & batch : batches)
+    {
+        pool.push(&batch);
+    }
+
+    // queues[i] connects chain[i] to chain[i + 1]. A null batch tells a worker that its input has ended.
+    std::vector<std::unique_ptr<BatchQueue>> queues;
+    for (size_t i = 0; i + 1 < chain.size(); ++i)
+    {
+        queues.push_back(std::make_unique<BatchQueue>(queueCapacity_));
+        chain[i + 1]->queueCapacity = queues.back()->capacity();
+    }
+
+    std::vector<std::unique_ptr<std::atomic<unsigned>>> running;
+    for (Node * node : chain)
+    {
+        running.push_back(std::make_unique<std::atomic<unsigned>>(node->parallelism));
+    }
+
+    stopped_   = false;
+    auto start = Clock::now();
+
+    std::vector<std::thread> workers;
+    for (size_t s = 0; s < chain.size(); ++s)
+    {
+        for (unsigned w = 0; w < chain[s]->parallelism; ++w)
+        {
+            workers.emplace_back([&, s, w] {
+                Node *       node   = chain[s];
+                BatchQueue * input  = (s > 0) ? queues[s - 1].get() : nullptr;
+                BatchQueue * output = (s + 1 < chain.size()) ? queues[s].get() : nullptr;
+
+                while (true)
+                {
+                    WordArena * batch;
+                    bool        more = true;
+                    if (input)
+                    {
+                        size_t depth = input->size();
+                        batch        = input->pop();
+                        if (!batch)
+                            break;
+                        node->depthSamples += 1;
+                        node->depthSum     += depth;
+                        size_t maxDepth     = node->maxDepth;
+                        while (depth > maxDepth && !node->maxDepth.compare_exchange_weak(maxDepth, depth))
+                        {
+                        }
+                    }
+                    else
+                    {
+                        if (stopped_)
+                            break;
+                        batch = pool.pop();
+                        batch->clear();
+                    }
+
+                    auto busyStart = Clock::now();
+                    if (node->source)
+                        more = node->source(*batch, w);
+                    else if (node->stage)
+                        node->stage(*batch, w);
+                    else
+                        node->sink(*batch, w);
+                    node->busyNanoseconds += nanosecondsSince(busyStart);
+                    node->batches         += 1;
+                    node->words           += batch->size();
+
+                    if (output && !batch->empty())
+                        output->push(batch);
+                    else
+                        pool.push(batch);
+
+                    if (!more)
+                        break;
+                }
+
+                // The last worker of a stage to finish ends the input of every worker of the next stage
+                if (--*running[s] == 0 && output)
+                {
+                    for (unsigned i = 0; i < chain[s + 1]->parallelism; ++i)
+                    {
+                        output->push(nullptr);
+                    }
+                }
+            });
+        }
+    }
+
+    for (auto & worker : workers)
+    {
+        worker.join();
+    }
+    runSeconds_ = nanosecondsSince(start) * 1e-9;
+}
+
+//! @return     The statistics of the most recent run
+
+std::vector<WordPipeline::Metrics> WordPipeline::metrics() const
+{
+    std::vector<Node const *> chain;
+    for (auto & node : nodes_)
+    {
+        chain.push_back(node.get());
+    }
+    if (sink_)
+        chain.push_back(sink_.get());
+
+    std::vector<Metrics> result;
+    for (Node const * node : chain)
+    {
+        Metrics m;
+        m.name              = node->name;
+        m.parallelism       = node->parallelism;
+        m.batches           = node->batches;
+        m.words             = node->words;
+        m.busySeconds       = node->busyNanoseconds * 1e-9;
+        m.utilization       = (runSeconds_ > 0.0) ? m.busySeconds / (runSeconds_ * node->parallelism) : 0.0;
+        m.averageQueueDepth = (node->depthSamples > 0) ? (double)node->depthSum / (double)node->depthSamples : 0.0;
+        m.maxQueueDepth     = node->maxDepth;
+        m.queueCapacity     = node->queueCapacity;
+        result.push_back(m);
+    }
+    return result;
+}
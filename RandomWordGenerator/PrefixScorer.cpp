@@ -0,0 +1,61 @@
+#include "PrefixScorer.h"
+
+#include "Generator.h"
+
+#include <algorithm>
+#include <limits>
+
+//! @param  generator   Model used to score the words
+PrefixScorer::PrefixScorer(RandomWordGenerator const & generator)
+    : generator_(generator)
+{
+    reset();
+}
+
+//! @param  word    A lowercase word
+//!
+//! @return     The natural log of the probability that the word is generated, or -infinity if it cannot be generated
+double PrefixScorer::logProbability(std::string_view word)
+{
+    // Resume from the state after the longest common prefix with the previous word
+
+    size_t n     = 0;
+    size_t limit = std::min(word.size(), previous_.size());
+    while (n < limit && word[n] == previous_[n])
+    {
+        ++n;
+    }
+    characterCount_ += word.size() + 1;
+    reusedCount_    += n;
+
+    previous_.resize(n);
+    states_.resize(n + 1);
+    State s = states_[n];
+
+    for (; n < word.size(); ++n)
+    {
+        char c = word[n];
+        if (c < 'a' || c > 'z')
+            return -std::numeric_limits<double>::infinity();
+        uint32_t i = (uint32_t)(c - 'a');
+
+        if (!s.probability.multiply(generator_.cdf(s.i0, s.i1, s.i2), i))
+            return -std::numeric_limits<double>::infinity();
+        s.i0 = s.i1;
+        s.i1 = s.i2;
+        s.i2 = i;
+
+        previous_ += c;
+        states_.push_back(s);
+    }
+
+    return s.probability.logProbability(generator_.cdf(s.i0, s.i1, s.i2));
+}
+
+void PrefixScorer::reset()
+{
+    static uint32_t constexpr T = (uint32_t)RandomWordGenerator::TERMINATOR;
+
+    previous_.clear();
+    states_.assign(1, { RandomWordGenerator::ProbabilityProduct(), T, T, T });
+}
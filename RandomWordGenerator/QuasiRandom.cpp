@@ -0,0 +1,129 @@
+#include "QuasiRandom.h"
+
+namespace
+{
+    // Primitive polynomials and initial direction numbers of dimensions 2 to 16 (Joe and Kuo, new-joe-kuo-6.21201)
+    struct Polynomial
+    {
+        uint32_t degree;
+        uint32_t coefficients;
+        uint32_t m[6];
+    };
+
+    static Polynomial constexpr POLYNOMIALS[QuasiRandomSequence::DIMENSIONS - 1] =
+    {
+        { 1,  0, { 1 } },
+        { 2,  1, { 1, 3 } },
+        { 3,  1, { 1, 3, 1 } },
+        { 3,  2, { 1, 1, 1 } },
+        { 4,  1, { 1, 1, 3, 3 } },
+        { 4,  4, { 1, 3, 5, 13 } },
+        { 5,  2, { 1, 1, 5, 5, 17 } },
+        { 5,  4, { 1, 1, 5, 5, 5 } },
+        { 5,  7, { 1, 1, 7, 11, 19 } },
+        { 5, 11, { 1, 1, 5, 1, 1 } },
+        { 5, 13, { 1, 1, 1, 3, 11 } },
+        { 5, 14, { 1, 3, 5, 5, 31 } },
+        { 6,  1, { 1, 3, 3, 9, 7, 49 } },
+        { 6, 13, { 1, 1, 1, 15, 21, 21 } },
+        { 6, 16, { 1, 3, 1, 13, 27, 49 } },
+    };
+
+    uint32_t reverseBits(uint32_t x)
+    {
+        x = ((x >> 1) & 0x55555555u) | ((x & 0x55555555u) << 1);
+        x = ((x >> 2) & 0x33333333u) | ((x & 0x33333333u) << 2);
+        x = ((x >> 4) & 0x0f0f0f0fu) | ((x & 0x0f0f0f0fu) << 4);
+        x = ((x >> 8) & 0x00ff00ffu) | ((x & 0x00ff00ffu) << 8);
+        return (x >> 16) | (x << 16);
+    }
+
+    // Owen scrambling of the bits of x, from the most significant bit down (Burley, 2020)
+    uint32_t scramble(uint32_t x, uint32_t seed)
+    {
+        x  = reverseBits(x);
+        x += seed;
+        x ^= x * 0x6c50b47cu;
+        x ^= x * 0xb82f1e52u;
+        x ^= x * 0xc7afe638u;
+        x ^= x * 0x8d22f6e6u;
+        return reverseBits(x);
+    }
+
+    uint64_t splitmix(uint64_t & state)
+    {
+        uint64_t z = (state += 0x9e3779b97f4a7c15ull);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+        return z ^ (z >> 31);
+    }
+}
+
+//! @param  seed    Seed of the scrambling
+QuasiRandomSequence::QuasiRandomSequence(uint64_t seed)
+{
+    // The first dimension is the van der Corput sequence
+    for (uint32_t k = 0; k < 32; ++k)
+    {
+        directions_[0][k] = 1u << (31 - k);
+    }
+
+    for (size_t j = 1; j < DIMENSIONS; ++j)
+    {
+        Polynomial const & p = POLYNOMIALS[j - 1];
+        uint32_t *         v = directions_[j];
+        for (uint32_t k = 0; k < p.degree; ++k)
+        {
+            v[k] = p.m[k] << (31 - k);
+        }
+        for (uint32_t k = p.degree; k < 32; ++k)
+        {
+            v[k] = v[k - p.degree] ^ (v[k - p.degree] >> p.degree);
+            for (uint32_t i = 1; i < p.degree; ++i)
+            {
+                if ((p.coefficients >> (p.degree - 1 - i)) & 1)
+                    v[k] ^= v[k - i];
+            }
+        }
+    }
+
+    for (size_t j = 0; j < DIMENSIONS; ++j)
+    {
+        seeds_[j] = (uint32_t)splitmix(seed);
+    }
+    seek(0);
+}
+
+//! @param  u   The coordinates of the point (returned)
+//!
+//! The points are generated in Gray code order, so each one differs from the previous one by a single direction number.
+void QuasiRandomSequence::next(float u[DIMENSIONS])
+{
+    uint32_t k = 0;
+    for (uint32_t i = index_; i & 1; i >>= 1)
+    {
+        ++k;
+    }
+    for (size_t j = 0; j < DIMENSIONS; ++j)
+    {
+        u[j]        = (float)(scramble(points_[j], seeds_[j]) >> 8) * (1.0f / (float)(1 << 24));
+        points_[j] ^= directions_[j][k & 31];
+    }
+    ++index_;
+}
+
+//! @param  index   Index of the next point
+void QuasiRandomSequence::seek(uint32_t index)
+{
+    uint32_t gray = index ^ (index >> 1);
+    for (size_t j = 0; j < DIMENSIONS; ++j)
+    {
+        points_[j] = 0;
+        for (uint32_t k = 0; k < 32; ++k)
+        {
+            if ((gray >> k) & 1)
+                points_[j] ^= directions_[j][k];
+        }
+    }
+    index_ = index;
+}
@@ -0,0 +1,565 @@
+#include "SharedWordSet.h"
+
+#include "Fingerprint.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <new>
+#include <thread>
+#include <vector>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+struct SharedWordSet::Header
+{
+    char                  magic[4];
+    uint32_t              version;
+    uint64_t              slotCount;    // A power of 2
+    uint64_t              arenaSize;
+    std::atomic<uint64_t> arenaUsed;    // May exceed arenaSize once the arena is full
+    std::atomic<uint64_t> count;
+    std::atomic<uint32_t> ready;        // Set by the creator once the header is initialized
+};
+
+struct SharedWordSet::Slot
+{
+    std::atomic<uint64_t> fingerprint;  // 0 if the slot is empty
+    std::atomic<uint64_t> offset;       // Offset of the word in the arena plus 1, 0 until published, or NO_WORD
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "Shared memory requires lock-free 64-bit atomics");
+
+namespace
+{
+    char constexpr     MAGIC[4]    = { 'R', 'W', 'G', 'h' };
+    uint32_t constexpr VERSION     = 1;
+    uint64_t constexpr NO_WORD     = UINT64_MAX;   // The slot was claimed but the arena was full
+    size_t constexpr   HEADER_SIZE = 64;
+
+    // Time allowed for the creator of a segment to initialize it
+    std::chrono::seconds constexpr INITIALIZATION_TIMEOUT(10);
+
+    // Time allowed for the process that claimed a slot to publish its word
+    std::chrono::seconds constexpr PUBLICATION_TIMEOUT(10);
+
+    // Returns the fingerprint stored in a slot for the fingerprint of a word, which is never 0
+    uint64_t slotFingerprint(uint64_t fingerprint)
+    {
+        return (fingerprint != 0) ? fingerprint : 1;
+    }
+
+    uint64_t slotCountFor(uint64_t capacity)
+    {
+        uint64_t n = 2;
+        while (n < capacity * 2)
+        {
+            n *= 2;
+        }
+        return n;
+    }
+
+    size_t segmentSize(uint64_t slotCount, uint64_t arenaSize)
+    {
+        return HEADER_SIZE + (size_t)slotCount * 2 * sizeof(uint64_t) + (size_t)arenaSize;
+    }
+
+#if defined(_WIN32)
+    std::string segmentName(std::string const & name)
+    {
+        return "Local\\" + name;
+    }
+#else
+    std::string segmentName(std::string const & name)
+    {
+        return (!name.empty() && name[0] == '/') ? name : "/" + name;
+    }
+#endif
+
+    template <typename T>
+    void store(std::ostream & s, T v)
+    {
+        s.write(reinterpret_cast<char const *>(&v), sizeof(v));
+    }
+
+    template <typename T>
+    bool load(std::istream & s, T & v)
+    {
+        return static_cast<bool>(s.read(reinterpret_cast<char *>(&v), sizeof(v)));
+    }
+}
+
+SharedWordSet::~SharedWordSet()
+{
+    close();
+}
+
+//! @param  name        Name of the segment
+//! @param  options     Size of the segment, if it is created
+//!
+//! @return     true if the segment was created or attached
+//!
+//! @note       If the segment already exists, its own size is used instead of the options.
+
+bool SharedWordSet::open(std::string const & name, Options const & options)
+{
+    close();
+    return create(name, options, false);
+}
+
+//! @param  name    Name of the segment
+//!
+//! @return     true if the segment was attached
+
+bool SharedWordSet::open(std::string const & name)
+{
+    close();
+    return attach(name);
+}
+
+void SharedWordSet::close()
+{
+#if defined(_WIN32)
+    if (data_)
+        UnmapViewOfFile(data_);
+    if (mapping_)
+        CloseHandle(mapping_);
+    mapping_ = nullptr;
+#else
+    if (data_)
+        munmap(data_, size_);
+    if (fd_ >= 0)
+        ::close(fd_);
+    fd_ = -1;
+#endif
+    data_   = nullptr;
+    size_   = 0;
+    header_ = nullptr;
+    slots_  = nullptr;
+    arena_  = nullptr;
+}
+
+//! @param  word    Word to insert
+//!
+//! @return     Whether the word was inserted, was already in the set, or could not be inserted
+
+SharedWordSet::Result SharedWordSet::insert(std::string_view word)
+{
+    return insert(word, WordFingerprint::of(word));
+}
+
+//! @param  word            Word to insert
+//! @param  fingerprint     WordFingerprint of the word
+//!
+//! @return     Whether the word was inserted, was already in the set, or could not be inserted
+
+SharedWordSet::Result SharedWordSet::insert(std::string_view word, uint64_t fingerprint)
+{
+    if (!header_)
+        return Result::FULL;
+
+    uint64_t fp   = slotFingerprint(fingerprint);
+    uint64_t mask = header_->slotCount - 1;
+    for (uint64_t i = fp & mask, probes = 0; probes <= mask; i = (i + 1) & mask, ++probes)
+    {
+        Slot &   slot    = slots_[i];
+        uint64_t current = slot.fingerprint.load(std::memory_order_acquire);
+        if (current == 0)
+        {
+            // Claim the slot, then append the word and publish its offset
+            if (slot.fingerprint.compare_exchange_strong(current, fp, std::memory_order_acq_rel))
+            {
+                uint64_t length = 4 + word.size();
+                uint64_t offset = header_->arenaUsed.fetch_add(length, std::memory_order_relaxed);
+                if (offset + length > header_->arenaSize)
+                {
+                    slot.offset.store(NO_WORD, std::memory_order_release);
+                    return Result::FULL;
+                }
+                uint32_t size = (uint32_t)word.size();
+                memcpy(arena_ + offset, &size, sizeof(size));
+                memcpy(arena_ + offset + 4, word.data(), word.size());
+                slot.offset.store(offset + 1, std::memory_order_release);
+                header_->count.fetch_add(1, std::memory_order_relaxed);
+                return Result::INSERTED;
+            }
+            // Another process claimed it first, and current is now its fingerprint
+        }
+        if (current == fp)
+        {
+            // The word may be the same, so wait for it to be published and compare. A slot that is never published was
+            // claimed by a process that died. It is marked as holding no word, so that later probes pass it at once.
+            uint64_t offset = slot.offset.load(std::memory_order_acquire);
+            if (offset == 0)
+            {
+                auto deadline = std::chrono::steady_clock::now() + PUBLICATION_TIMEOUT;
+                while ((offset = slot.offset.load(std::memory_order_acquire)) == 0 && std::chrono::steady_clock::now() < deadline)
+                {
+                    std::this_thread::yield();
+                }
+                // If the word was published just now, offset is set to it instead
+                if (offset == 0)
+                    slot.offset.compare_exchange_strong(offset, NO_WORD, std::memory_order_acq_rel);
+            }
+            if (offset != 0 && offset != NO_WORD && wordAt(offset - 1) == word)
+                return Result::EXISTS;
+        }
+    }
+    return Result::FULL;
+}
+
+//! @param  word    Word to look for
+//!
+//! @return     true if the word is in the set
+
+bool SharedWordSet::contains(std::string_view word) const
+{
+    return contains(word, WordFingerprint::of(word));
+}
+
+//! @param  word            Word to look for
+//! @param  fingerprint     WordFingerprint of the word
+//!
+//! @return     true if the word is in the set
+
+bool SharedWordSet::contains(std::string_view word, uint64_t fingerprint) const
+{
+    if (!header_)
+        return false;
+
+    uint64_t fp   = slotFingerprint(fingerprint);
+    uint64_t mask = header_->slotCount - 1;
+    for (uint64_t i = fp & mask, probes = 0; probes <= mask; i = (i + 1) & mask, ++probes)
+    {
+        Slot const & slot    = slots_[i];
+        uint64_t     current = slot.fingerprint.load(std::memory_order_acquire);
+        if (current == 0)
+            return false;
+        if (current == fp)
+        {
+            uint64_t offset = slot.offset.load(std::memory_order_acquire);
+            if (offset != 0 && offset != NO_WORD && wordAt(offset - 1) == word)
+                return true;
+        }
+    }
+    return false;
+}
+
+//! @return     The number of words in the set
+
+uint64_t SharedWordSet::size() const
+{
+    return header_ ? header_->count.load(std::memory_order_relaxed) : 0;
+}
+
+//! @param  f   Function called with each word. Iteration stops when it returns false.
+
+void SharedWordSet::forEach(std::function<bool(std::string_view word)> const & f) const
+{
+    if (!header_)
+        return;
+
+    for (uint64_t i = 0; i < header_->slotCount; ++i)
+    {
+        uint64_t offset = slots_[i].offset.load(std::memory_order_acquire);
+        if (offset != 0 && offset != NO_WORD && !f(wordAt(offset - 1)))
+            return;
+    }
+}
+
+//! @param  filename    Name of the file
+//!
+//! @return     true if the file was written
+
+bool SharedWordSet::save(char const * filename) const
+{
+    if (!header_)
+        return false;
+
+    std::ofstream out(filename, std::ios::binary);
+    if (!out)
+        return false;
+
+    uint64_t arenaUsed = std::min(header_->arenaUsed.load(), header_->arenaSize);
+    out.write(MAGIC, sizeof(MAGIC));
+    store(out, VERSION);
+    store(out, header_->slotCount);
+    store(out, header_->arenaSize);
+    store(out, arenaUsed);
+    store(out, header_->count.load());
+
+    // The slots are written in blocks of plain integers
+    std::vector<uint64_t> block;
+    for (uint64_t i = 0; i < header_->slotCount && out; i += 65536)
+    {
+        uint64_t n = std::min<uint64_t>(65536, header_->slotCount - i);
+        block.resize((size_t)n * 2);
+        for (uint64_t j = 0; j < n; ++j)
+        {
+            block[j * 2]     = slots_[i + j].fingerprint.load(std::memory_order_relaxed);
+            block[j * 2 + 1] = slots_[i + j].offset.load(std::memory_order_relaxed);
+        }
+        out.write(reinterpret_cast<char const *>(block.data()), (std::streamsize)(block.size() * sizeof(uint64_t)));
+    }
+    out.write(reinterpret_cast<char const *>(arena_), (std::streamsize)arenaUsed);
+    return static_cast<bool>(out.flush());
+}
+
+//! @param  name        Name of the segment to create
+//! @param  filename    Name of a file written by save()
+//!
+//! @return     true if the segment was created and filled
+
+bool SharedWordSet::restore(std::string const & name, char const * filename)
+{
+    std::ifstream in(filename, std::ios::binary);
+    if (!in)
+        return false;
+
+    char     magic[4];
+    uint32_t version;
+    uint64_t slotCount;
+    uint64_t arenaSize;
+    uint64_t arenaUsed;
+    uint64_t count;
+    if (!in.read(magic, sizeof(magic)) || memcmp(magic, MAGIC, sizeof(MAGIC)) != 0)
+        return false;
+    if (!load(in, version) || version != VERSION)
+        return false;
+    if (!load(in, slotCount) || !load(in, arenaSize) || !load(in, arenaUsed) || !load(in, count))
+        return false;
+    if (slotCount < 2 || (slotCount & (slotCount - 1)) != 0 || arenaUsed > arenaSize)
+        return false;
+
+    // The segment is created with the saved sizes, but it is not marked ready until it is filled
+    SharedWordSet set;
+    Options       options;
+    options.capacity  = slotCount / 2;
+    options.arenaSize = arenaSize;
+    if (!set.create(name, options, true))
+        return false;
+
+    bool                  ok = true;
+    std::vector<uint64_t> block;
+    for (uint64_t i = 0; i < slotCount && ok; i += 65536)
+    {
+        uint64_t n = std::min<uint64_t>(65536, slotCount - i);
+        block.resize((size_t)n * 2);
+        ok = static_cast<bool>(in.read(reinterpret_cast<char *>(block.data()), (std::streamsize)(block.size() * sizeof(uint64_t))));
+        for (uint64_t j = 0; j < n && ok; ++j)
+        {
+            set.slots_[i + j].fingerprint.store(block[j * 2], std::memory_order_relaxed);
+            set.slots_[i + j].offset.store(block[j * 2 + 1], std::memory_order_relaxed);
+        }
+    }
+    ok = ok && in.read(reinterpret_cast<char *>(set.arena_), (std::streamsize)arenaUsed);
+
+    // Every published word, with its length, must be within the used part of the arena, and their number must be the count
+    uint64_t published = 0;
+    for (uint64_t i = 0; i < slotCount && ok; ++i)
+    {
+        uint64_t offset = set.slots_[i].offset.load(std::memory_order_relaxed);
+        if (offset == 0 || offset == NO_WORD)
+            continue;
+        uint32_t size = 0;
+        ok = arenaUsed >= 4 && offset - 1 <= arenaUsed - 4;
+        if (ok)
+        {
+            memcpy(&size, set.arena_ + offset - 1, sizeof(size));
+            ok = size <= arenaUsed - 4 - (offset - 1);
+        }
+        ++published;
+    }
+    ok = ok && published == count;
+    if (!ok)
+    {
+        set.close();
+        remove(name);
+        return false;
+    }
+
+    set.header_->arenaUsed.store(arenaUsed);
+    set.header_->count.store(count);
+    set.header_->ready.store(1, std::memory_order_release);
+    return true;
+}
+
+//! @param  name    Name of the segment
+//!
+//! @return     true if the segment was removed
+//!
+//! @note       On Windows, a segment is freed when the last process detaches, so this does nothing.
+
+bool SharedWordSet::remove(std::string const & name)
+{
+#if defined(_WIN32)
+    (void)name;
+    return true;
+#else
+    return shm_unlink(segmentName(name).c_str()) == 0;
+#endif
+}
+
+// Creates the segment, or attaches to it if it already exists and exclusive is not set. A created segment is marked ready
+// unless exclusive is set, in which case the caller fills it and marks it ready.
+bool SharedWordSet::create(std::string const & name, Options const & options, bool exclusive)
+{
+    uint64_t slotCount = slotCountFor(std::max<uint64_t>(options.capacity, 1));
+    size_t   size      = segmentSize(slotCount, options.arenaSize);
+
+#if defined(_WIN32)
+    HANDLE mapping = CreateFileMappingA(INVALID_HANDLE_VALUE,
+                                        nullptr,
+                                        PAGE_READWRITE,
+                                        (DWORD)((uint64_t)size >> 32),
+                                        (DWORD)size,
+                                        segmentName(name).c_str());
+    if (!mapping)
+        return false;
+    bool existed = GetLastError() == ERROR_ALREADY_EXISTS;
+    CloseHandle(mapping);
+    if (existed)
+        return !exclusive && attach(name);
+
+    // The handle must stay open or the mapping disappears, so it is opened again and kept
+    mapping_ = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, segmentName(name).c_str());
+    if (!mapping_)
+        return false;
+#else
+    fd_ = shm_open(segmentName(name).c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd_ < 0)
+        return errno == EEXIST && !exclusive && attach(name);
+    // On Linux the memory is allocated now, so that a full /dev/shm is reported here instead of by a SIGBUS when a page is
+    // first touched
+#if defined(__linux__)
+    if (posix_fallocate(fd_, 0, (off_t)size) != 0)
+#else
+    if (ftruncate(fd_, (off_t)size) != 0)
+#endif
+    {
+        close();
+        remove(name);
+        return false;
+    }
+#endif
+
+    if (!map(size))
+    {
+        close();
+        remove(name);
+        return false;
+    }
+
+    // The new segment is filled with zeros, so the slots are already empty
+    static_assert(sizeof(Header) <= HEADER_SIZE && sizeof(Slot) == 2 * sizeof(uint64_t), "Unexpected layout");
+    header_ = new (data_) Header;
+    memcpy(header_->magic, MAGIC, sizeof(MAGIC));
+    header_->version   = VERSION;
+    header_->slotCount = slotCount;
+    header_->arenaSize = options.arenaSize;
+    header_->arenaUsed.store(0);
+    header_->count.store(0);
+    header_->ready.store(0);
+    slots_ = reinterpret_cast<Slot *>(data_ + HEADER_SIZE);
+    arena_ = data_ + HEADER_SIZE + slotCount * sizeof(Slot);
+
+    if (!exclusive)
+        header_->ready.store(1, std::memory_order_release);
+    return true;
+}
+
+// Attaches to an existing segment, waiting for its creator to initialize it
+bool SharedWordSet::attach(std::string const & name)
+{
+    auto deadline = std::chrono::steady_clock::now() + INITIALIZATION_TIMEOUT;
+
+#if defined(_WIN32)
+    mapping_ = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, segmentName(name).c_str());
+    if (!mapping_)
+        return false;
+    if (!map(0))
+    {
+        close();
+        return false;
+    }
+#else
+    fd_ = shm_open(segmentName(name).c_str(), O_RDWR, 0);
+    if (fd_ < 0)
+        return false;
+
+    // The segment has no size until its creator sets it
+    struct stat status;
+    while (fstat(fd_, &status) == 0 && status.st_size == 0 && std::chrono::steady_clock::now() < deadline)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    if (fstat(fd_, &status) != 0 || (size_t)status.st_size < HEADER_SIZE || !map((size_t)status.st_size))
+    {
+        close();
+        return false;
+    }
+#endif
+
+    while (header_->ready.load(std::memory_order_acquire) == 0 && std::chrono::steady_clock::now() < deadline)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    if (header_->ready.load(std::memory_order_acquire) == 0 ||
+        memcmp(header_->magic, MAGIC, sizeof(MAGIC)) != 0 ||
+        header_->version != VERSION ||
+        segmentSize(header_->slotCount, header_->arenaSize) > size_)
+    {
+        close();
+        return false;
+    }
+
+    slots_ = reinterpret_cast<Slot *>(data_ + HEADER_SIZE);
+    arena_ = data_ + HEADER_SIZE + header_->slotCount * sizeof(Slot);
+    return true;
+}
+
+// Maps the segment. A size of 0 maps the whole segment.
+bool SharedWordSet::map(size_t size)
+{
+#if defined(_WIN32)
+    void * view = MapViewOfFile(mapping_, FILE_MAP_ALL_ACCESS, 0, 0, size);
+    if (!view)
+        return false;
+    if (size == 0)
+    {
+        MEMORY_BASIC_INFORMATION info;
+        if (VirtualQuery(view, &info, sizeof(info)) == 0)
+        {
+            UnmapViewOfFile(view);
+            return false;
+        }
+        size = info.RegionSize;
+    }
+#else
+    void * view = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (view == MAP_FAILED)
+        return false;
+#endif
+    data_   = static_cast<uint8_t *>(view);
+    size_   = size;
+    header_ = reinterpret_cast<Header *>(data_);
+    return true;
+}
+
+// Returns the word at an offset in the arena
+std::string_view SharedWordSet::wordAt(uint64_t offset) const
+{
+    uint32_t size;
+    memcpy(&size, arena_ + offset, sizeof(size));
+    return std::string_view(reinterpret_cast<char const *>(arena_ + offset + 4), size);
+}
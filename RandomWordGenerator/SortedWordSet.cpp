@@ -0,0 +1,332 @@
+#include "SortedWordSet.h"
+
+#include <algorithm>
+#include <cstring>
+#include <ostream>
+
+namespace
+{
+    char constexpr     MAGIC[4]    = { 'R', 'W', 'G', 'S' };
+    uint32_t constexpr VERSION     = 1;
+    size_t constexpr   HEADER_SIZE = 32;
+
+    // File layout (little-endian):
+    //
+    //      0   magic
+    //      4   version
+    //      8   number of words
+    //      16  words per block
+    //      20  number of blocks
+    //      24  offset of the index
+    //      32  blocks
+    //          index: offset of each block, followed by the end of the last block
+
+    template <typename T>
+    T load(uint8_t const * p)
+    {
+        T v;
+        memcpy(&v, p, sizeof(v));
+        return v;
+    }
+
+    template <typename T>
+    void store(std::ostream & s, T v)
+    {
+        s.write(reinterpret_cast<char const *>(&v), sizeof(v));
+    }
+
+    size_t writeVarint(std::ostream & s, uint64_t v)
+    {
+        size_t n = 0;
+        while (v >= 0x80)
+        {
+            s.put((char)(v | 0x80));
+            v >>= 7;
+            ++n;
+        }
+        s.put((char)v);
+        return n + 1;
+    }
+
+    bool readVarint(uint8_t const *& p, uint8_t const * end, size_t & v)
+    {
+        v = 0;
+        for (int shift = 0; p < end && shift < 64; shift += 7)
+        {
+            uint8_t byte = *p++;
+            v |= (size_t)(byte & 0x7f) << shift;
+            if ((byte & 0x80) == 0)
+                return true;
+        }
+        return false;
+    }
+
+    // Decodes the words of a block in order
+    class Cursor
+    {
+    public:
+        Cursor(uint8_t const * begin, uint8_t const * end)
+            : p_(begin)
+            , end_(end)
+        {
+        }
+
+        // Decodes the next word. Returns false at the end of the block.
+        bool next()
+        {
+            size_t shared = 0;
+            size_t length;
+            if (first_)
+            {
+                if (!readVarint(p_, end_, length))
+                    return false;
+                first_ = false;
+            }
+            else if (!readVarint(p_, end_, shared) || !readVarint(p_, end_, length) || shared > word_.size())
+            {
+                return false;
+            }
+            if (length > (size_t)(end_ - p_))
+                return false;
+            word_.resize(shared);
+            word_.append(reinterpret_cast<char const *>(p_), length);
+            p_ += length;
+            return true;
+        }
+
+        std::string_view word() const { return word_; }
+
+    private:
+        uint8_t const * p_;
+        uint8_t const * end_;
+        std::string     word_;
+        bool            first_ = true;
+    };
+}
+
+//! @param  words       Words to store. They are sorted and duplicates are removed.
+//! @param  out         Receives the set
+//! @param  blockSize   Number of words in each block. Larger blocks are smaller but slower to query.
+//!
+//! @return     false if the set could not be written
+
+bool SortedWordSet::write(std::vector<std::string> & words, std::ostream & out, uint32_t blockSize /*= DEFAULT_BLOCK_SIZE*/)
+{
+    if (blockSize == 0)
+        return false;
+
+    std::sort(words.begin(), words.end());
+    words.erase(std::unique(words.begin(), words.end()), words.end());
+
+    uint64_t count      = words.size();
+    uint32_t blockCount = (uint32_t)((count + blockSize - 1) / blockSize);
+
+    std::vector<uint64_t> offsets;
+    offsets.reserve(blockCount + 1);
+
+    // Write a placeholder header, since the offset of the index is not known yet
+    char header[HEADER_SIZE] = {};
+    out.write(header, sizeof(header));
+
+    uint64_t offset = HEADER_SIZE;
+    for (uint64_t i = 0; i < count; ++i)
+    {
+        std::string const & word = words[i];
+        if (i % blockSize == 0)
+        {
+            offsets.push_back(offset);
+            offset += writeVarint(out, word.size());
+            out.write(word.data(), word.size());
+            offset += word.size();
+        }
+        else
+        {
+            std::string const & previous = words[i - 1];
+            size_t              shared   = std::mismatch(previous.begin(), previous.end(), word.begin(), word.end()).first - previous.begin();
+            offset += writeVarint(out, shared);
+            offset += writeVarint(out, word.size() - shared);
+            out.write(word.data() + shared, word.size() - shared);
+            offset += word.size() - shared;
+        }
+    }
+    offsets.push_back(offset);
+
+    // Align the index
+    while (offset % sizeof(uint64_t) != 0)
+    {
+        out.put(0);
+        ++offset;
+    }
+    uint64_t indexOffset = offset;
+    for (uint64_t o : offsets)
+    {
+        store(out, o);
+    }
+
+    out.seekp(0);
+    out.write(MAGIC, sizeof(MAGIC));
+    store(out, VERSION);
+    store(out, count);
+    store(out, blockSize);
+    store(out, blockCount);
+    store(out, indexOffset);
+    out.seekp(0, std::ios::end);
+
+    return (bool)out;
+}
+
+//! @param  filename    Name of a file written by write()
+//!
+//! @return     true if the set was opened
+
+bool SortedWordSet::open(char const * filename)
+{
+    count_      = 0;
+    blockCount_ = 0;
+    index_      = nullptr;
+
+    if (!file_.open(filename))
+        return false;
+
+    uint8_t const * data = file_.data();
+    size_t          size = file_.size();
+    if (size < HEADER_SIZE || memcmp(data, MAGIC, sizeof(MAGIC)) != 0 || load<uint32_t>(data + 4) != VERSION)
+        return false;
+
+    uint64_t count       = load<uint64_t>(data + 8);
+    uint32_t blockSize   = load<uint32_t>(data + 16);
+    uint32_t blockCount  = load<uint32_t>(data + 20);
+    uint64_t indexOffset = load<uint64_t>(data + 24);
+    if (blockSize == 0 || (count + blockSize - 1) / blockSize != blockCount)
+        return false;
+    if (indexOffset > size || (size - indexOffset) / sizeof(uint64_t) < (uint64_t)blockCount + 1)
+        return false;
+
+    // The blocks must be in order and lie between the header and the index
+    uint64_t previous = HEADER_SIZE;
+    for (uint32_t b = 0; b <= blockCount; ++b)
+    {
+        uint64_t offset = load<uint64_t>(data + indexOffset + b * sizeof(uint64_t));
+        if (offset < previous || offset > indexOffset)
+            return false;
+        previous = offset;
+    }
+
+    count_      = count;
+    blockSize_  = blockSize;
+    blockCount_ = blockCount;
+    index_      = data + indexOffset;
+    return true;
+}
+
+//! @param  word    Word to find
+//!
+//! @return     true if the word is in the set
+
+bool SortedWordSet::contains(std::string_view word) const
+{
+    if (blockCount_ == 0)
+        return false;
+
+    uint32_t b = findBlock(word);
+    Cursor   cursor(block(b), blockEnd(b));
+    while (cursor.next())
+    {
+        int c = cursor.word().compare(word);
+        if (c >= 0)
+            return c == 0;
+    }
+    return false;
+}
+
+//! @param  word    Word to find
+//!
+//! @return     The rank of the first word that is not less than @a word, or size() if there is none
+
+uint64_t SortedWordSet::lowerBound(std::string_view word) const
+{
+    if (blockCount_ == 0)
+        return 0;
+
+    uint32_t b    = findBlock(word);
+    uint64_t rank = (uint64_t)b * blockSize_;
+    Cursor   cursor(block(b), blockEnd(b));
+    while (cursor.next() && cursor.word() < word)
+    {
+        ++rank;
+    }
+    return rank;
+}
+
+//! @param  prefix  Prefix of the words to find
+//!
+//! @return     The ranks [first, last) of the words starting with @a prefix
+
+std::pair<uint64_t, uint64_t> SortedWordSet::prefixRange(std::string_view prefix) const
+{
+    uint64_t first = lowerBound(prefix);
+
+    // The words starting with the prefix end before the smallest string greater than every such word
+    std::string successor(prefix);
+    while (!successor.empty() && (uint8_t)successor.back() == 0xff)
+    {
+        successor.pop_back();
+    }
+    if (successor.empty())
+        return { first, count_ };
+    successor.back() = (char)((uint8_t)successor.back() + 1);
+
+    return { first, lowerBound(successor) };
+}
+
+//! @param  first   Rank of the first word
+//! @param  last    Rank following the last word
+//! @param  f       Function called with each word. The string_view is only valid during the call.
+
+void SortedWordSet::forEach(uint64_t first, uint64_t last, std::function<void(std::string_view)> const & f) const
+{
+    last = std::min(last, count_);
+    while (first < last)
+    {
+        uint32_t b    = (uint32_t)(first / blockSize_);
+        uint64_t rank = (uint64_t)b * blockSize_;
+        Cursor   cursor(block(b), blockEnd(b));
+        while (rank < last && cursor.next())
+        {
+            if (rank >= first)
+                f(cursor.word());
+            ++rank;
+        }
+        first = (uint64_t)(b + 1) * blockSize_;
+    }
+}
+
+uint8_t const * SortedWordSet::block(uint32_t b) const
+{
+    return file_.data() + load<uint64_t>(index_ + b * sizeof(uint64_t));
+}
+
+uint8_t const * SortedWordSet::blockEnd(uint32_t b) const
+{
+    return block(b + 1);
+}
+
+// Returns the last block whose first word is not greater than the word, or 0 if there is none
+uint32_t SortedWordSet::findBlock(std::string_view word) const
+{
+    uint32_t lo = 0;
+    uint32_t hi = blockCount_;
+    while (hi - lo > 1)
+    {
+        uint32_t        mid = lo + (hi - lo) / 2;
+        uint8_t const * p   = block(mid);
+        size_t          length;
+        readVarint(p, blockEnd(mid), length);
+        std::string_view first(reinterpret_cast<char const *>(p), std::min(length, (size_t)(blockEnd(mid) - p)));
+        if (first <= word)
+            lo = mid;
+        else
+            hi = mid;
+    }
+    return lo;
+}
@@ -0,0 +1,112 @@
+#include "SparseGenerator.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace
+{
+    // Returns true if a row is the one given to contexts that were never observed, which always chooses the terminator
+    bool isTerminatorRow(float const * cdf)
+    {
+        for (size_t m = 0; m < RandomWordGenerator::ALPHABET_SIZE; ++m)
+        {
+            if (cdf[m] != 0.0f)
+                return false;
+        }
+        return cdf[RandomWordGenerator::TERMINATOR] == 1.0f;
+    }
+}
+
+//! @param  cdfs    Dense table of CDFs, laid out as RandomWordGenerator::Table
+//!
+//! @note       If the index cannot be built, which does not happen in practice, every context gets the terminator row.
+
+SparseGenerator::SparseGenerator(float const * cdfs)
+{
+    terminatorRow_[RandomWordGenerator::TERMINATOR] = 1.0f;
+
+    std::vector<uint64_t> keys;
+    for (size_t c = 0; c < N * N * N; ++c)
+    {
+        if (!isTerminatorRow(cdfs + c * N))
+            keys.push_back(c);
+    }
+    if (!index_.build(keys))
+        return;
+
+    rows_.resize(keys.size() * ROW_SIZE);
+    for (uint64_t c : keys)
+    {
+        float *  row = &rows_[index_.row(c) * ROW_SIZE];
+        uint32_t key = (uint32_t)c;
+        memcpy(row, cdfs + c * N, N * sizeof(float));
+        memcpy(row + N, &key, sizeof(key));
+    }
+}
+
+//! @param  generator   Generator whose table is copied
+SparseGenerator::SparseGenerator(RandomWordGenerator const & generator)
+    : SparseGenerator(generator.cdf(0, 0, 0))
+{
+}
+
+//! @param  rng         Entropy source
+//! @param  maxLength   Maximum number of characters in the word, or 0 if the length is unbounded
+//!
+//! @return     The generated word
+
+std::string SparseGenerator::operator ()(std::minstd_rand & rng, size_t maxLength /* = 0*/) const
+{
+    std::uniform_real_distribution<float> randomFloat(0.0f, 1.0f);
+    std::string                           word;
+    size_t                                c = context(RandomWordGenerator::TERMINATOR, RandomWordGenerator::TERMINATOR, RandomWordGenerator::TERMINATOR);
+
+    while (word.size() <= maxLength || maxLength == 0)
+    {
+        float const * cdf = row(c);
+        size_t        i   = std::upper_bound(cdf, cdf + N, randomFloat(rng)) - cdf;
+        if (i >= RandomWordGenerator::ALPHABET_SIZE)
+            break;
+        word += (char)('a' + i);
+        c     = c % (N * N) * N + i;
+    }
+    return word;
+}
+
+//! @param  word    Word to evaluate
+//!
+//! @return     The log probability of the word (including its terminator), or -infinity if the word cannot be generated
+
+double SparseGenerator::logProbability(std::string_view word) const
+{
+    RandomWordGenerator::ProbabilityProduct probability;
+    size_t c = context(RandomWordGenerator::TERMINATOR, RandomWordGenerator::TERMINATOR, RandomWordGenerator::TERMINATOR);
+
+    for (char ch : word)
+    {
+        if (ch < 'a' || ch > 'z')
+            return -std::numeric_limits<double>::infinity();
+
+        size_t i = (size_t)(ch - 'a');
+        if (!probability.multiply(row(c), i))
+            return -std::numeric_limits<double>::infinity();
+        c = c % (N * N) * N + i;
+    }
+
+    return probability.logProbability(row(c));
+}
+
+// Returns the row of a context, or the terminator row if it was not observed. The index rejects most such contexts by
+// their fingerprints, and the context stored in the row rejects the rest.
+float const * SparseGenerator::row(size_t context) const
+{
+    size_t r = index_.find(context);
+    if (r == ContextIndex::NOT_FOUND)
+        return terminatorRow_;
+
+    float const * row = &rows_[r * ROW_SIZE];
+    uint32_t      key;
+    memcpy(&key, row + N, sizeof(key));
+    return (key == context) ? row : terminatorRow_;
+}
@@ -0,0 +1,293 @@
+#include "TunedGenerator.h"
+
+#include "Fingerprint.h"
+#include "Generator.h"
+#include "HierarchicalSampler.h"
+#include "SparseGenerator.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+
+namespace
+{
+    char const * const SAMPLER_NAMES[]  = { "table", "hierarchical", "sparse" };
+    size_t constexpr   VALIDATION_COUNT = 1000;    // Number of words compared with those of the table
+    unsigned constexpr RUN_COUNT        = 3;       // Number of timed runs of each sampler, of which the fastest is used
+
+    // Minimum duration of a timed run. Shorter runs are too noisy to compare.
+    std::chrono::milliseconds constexpr MINIMUM_RUN_TIME(10);
+
+    // Replaces the characters that separate the fields of the cache and trims the spaces at both ends
+    std::string clean(std::string s)
+    {
+        std::replace(s.begin(), s.end(), '\t', ' ');
+        std::replace(s.begin(), s.end(), '\n', ' ');
+        size_t begin = s.find_first_not_of(' ');
+        size_t end   = s.find_last_not_of(' ');
+        return (begin != std::string::npos) ? s.substr(begin, end - begin + 1) : std::string();
+    }
+
+    // Cache format: one decision per line, as the CPU model, the checksum of the model in hex, and the name of the sampler,
+    // separated by tabs. Later lines override earlier ones.
+
+    bool findDecision(char const * cacheFile, std::string const & key, TunedGenerator::Sampler & sampler)
+    {
+        std::ifstream in(cacheFile);
+        std::string   line;
+        bool          found = false;
+        while (std::getline(in, line))
+        {
+            size_t tab = line.rfind('\t');
+            if (tab == std::string::npos || line.compare(0, tab, key) != 0)
+                continue;
+            for (size_t i = 0; i < TunedGenerator::SAMPLER_COUNT; ++i)
+            {
+                if (line.compare(tab + 1, std::string::npos, SAMPLER_NAMES[i]) == 0)
+                {
+                    sampler = (TunedGenerator::Sampler)i;
+                    found   = true;
+                }
+            }
+        }
+        return found;
+    }
+
+    void saveDecision(char const * cacheFile, std::string const & key, TunedGenerator::Sampler sampler)
+    {
+        // The line is appended in a single write, so processes tuning at the same time do not mix their lines
+        std::string line = key + '\t' + SAMPLER_NAMES[(size_t)sampler] + '\n';
+        std::ofstream out(cacheFile, std::ios::app);
+        out.write(line.data(), line.size());
+    }
+}
+
+//! @param  generator   Generator whose words are generated
+TunedGenerator::TunedGenerator(RandomWordGenerator & generator)
+    : generator_(generator)
+{
+}
+
+TunedGenerator::~TunedGenerator() = default;
+
+//! @param  cacheFile   File holding the decisions made previously, or nullptr
+//!
+//! @return     The sampler chosen
+//!
+//! @note       Each sampler is measured for a few tens of milliseconds. The measurements are only meaningful if the
+//!             computer is otherwise idle.
+
+TunedGenerator::Sampler TunedGenerator::tune(char const * cacheFile /* = nullptr */)
+{
+    cached_ = false;
+    std::fill(std::begin(times_), std::end(times_), 0.0);
+
+    char checksum[17];
+    snprintf(checksum, sizeof(checksum), "%016llx", (unsigned long long)generator_.checksum());
+    std::string key = cpuModel() + '\t' + checksum;
+
+    Sampler best;
+    if (cacheFile && findDecision(cacheFile, key, best))
+    {
+        use(best);
+        cached_ = true;
+        return best;
+    }
+
+    // The table is always valid, so it is the fallback
+    best = Sampler::TABLE;
+    for (size_t i = 0; i < SAMPLER_COUNT; ++i)
+    {
+        Sampler sampler = (Sampler)i;
+        build(sampler);
+        if (!isValid(sampler))
+            continue;
+        times_[i] = measure(sampler);
+        if (times_[i] < times_[(size_t)best])
+            best = sampler;
+    }
+    use(best);
+
+    if (cacheFile)
+        saveDecision(cacheFile, key, best);
+    return best;
+}
+
+//! @param  sampler     Sampler to use
+void TunedGenerator::use(Sampler sampler)
+{
+    build(sampler);
+    sampler_ = sampler;
+    release();
+}
+
+//! @param  rng         Entropy source
+//! @param  maxLength   Maximum number of characters in the word. If max_length == 0, then the length is unbounded.
+//!
+//! @return     The generated word
+
+std::string TunedGenerator::operator ()(std::minstd_rand & rng, size_t maxLength /* = 0*/) const
+{
+    return generate(sampler_, rng, maxLength);
+}
+
+//! @param  rng             Entropy source
+//! @param  fingerprint     Receives the characters of the word
+//! @param  maxLength       Maximum number of characters in the word. If max_length == 0, then the length is unbounded.
+//!
+//! @return     The generated word
+//!
+//! @note       Only the table computes the fingerprint as the word is generated. The other samplers append the finished
+//!             word, which is nearly as fast.
+
+std::string TunedGenerator::operator ()(std::minstd_rand & rng, WordFingerprint & fingerprint, size_t maxLength /* = 0*/) const
+{
+    if (sampler_ == Sampler::TABLE)
+        return generator_(rng, fingerprint, maxLength);
+
+    std::string word = generate(sampler_, rng, maxLength);
+    fingerprint.append(word);
+    return word;
+}
+
+//! @param  sampler     A sampler
+//!
+//! @return     The name of the sampler
+
+char const * TunedGenerator::name(Sampler sampler)
+{
+    return SAMPLER_NAMES[(size_t)sampler];
+}
+
+//! @return     The model name of the CPU, or "unknown" if it cannot be determined
+
+std::string TunedGenerator::cpuModel()
+{
+    std::string model;
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    int registers[4];
+    __cpuid(registers, 0x80000000);
+    if ((unsigned)registers[0] >= 0x80000004)
+    {
+        for (int i = 0; i < 3; ++i)
+        {
+            __cpuid(registers, 0x80000002 + i);
+            model.append(reinterpret_cast<char const *>(registers), sizeof(registers));
+        }
+    }
+#elif defined(__x86_64__) || defined(__i386__)
+    unsigned registers[4];
+    if (__get_cpuid(0x80000000, &registers[0], &registers[1], &registers[2], &registers[3]) && registers[0] >= 0x80000004)
+    {
+        for (unsigned i = 0; i < 3; ++i)
+        {
+            __get_cpuid(0x80000002 + i, &registers[0], &registers[1], &registers[2], &registers[3]);
+            model.append(reinterpret_cast<char const *>(registers), sizeof(registers));
+        }
+    }
+#else
+    // Other CPUs identify themselves in /proc/cpuinfo on Linux, with different field names
+    std::ifstream in("/proc/cpuinfo");
+    std::string   line;
+    while (model.empty() && std::getline(in, line))
+    {
+        size_t colon = line.find(':');
+        if (colon == std::string::npos)
+            continue;
+        std::string field = clean(line.substr(0, colon));
+        if (field == "model name" || field == "Model" || field == "Hardware" || field == "cpu model" || field == "cpu")
+            model = line.substr(colon + 1);
+    }
+#endif
+
+    model = clean(model.substr(0, model.find('\0')));
+    return !model.empty() ? model : "unknown";
+}
+
+std::string TunedGenerator::generate(Sampler sampler, std::minstd_rand & rng, size_t maxLength) const
+{
+    switch (sampler)
+    {
+        case Sampler::HIERARCHICAL:
+            return (*hierarchical_)(rng, maxLength);
+        case Sampler::SPARSE:
+            return (*sparse_)(rng, maxLength);
+        default:
+            return generator_(rng, maxLength);
+    }
+}
+
+// Creates the structures used by a sampler
+void TunedGenerator::build(Sampler sampler)
+{
+    if (sampler == Sampler::HIERARCHICAL && !hierarchical_)
+        hierarchical_ = std::make_unique<HierarchicalSampler>(generator_);
+    else if (sampler == Sampler::SPARSE && !sparse_)
+        sparse_ = std::make_unique<SparseGenerator>(generator_);
+}
+
+// Returns true if a sampler generates the same words as the table
+bool TunedGenerator::isValid(Sampler sampler) const
+{
+    std::minstd_rand expected(VALIDATION_COUNT);
+    std::minstd_rand actual(VALIDATION_COUNT);
+    for (size_t i = 0; i < VALIDATION_COUNT; ++i)
+    {
+        if (generator_(expected) != generate(sampler, actual, 0))
+            return false;
+    }
+    return true;
+}
+
+// Returns the time taken by a sampler to generate a word, in nanoseconds. The number of words is doubled until a run takes
+// long enough to measure, and then the fastest of several runs is used.
+double TunedGenerator::measure(Sampler sampler) const
+{
+    using Clock = std::chrono::steady_clock;
+
+    size_t characters = 0;
+    auto   run        = [&](size_t count) {
+        std::minstd_rand rng(1);
+        Clock::time_point start = Clock::now();
+        for (size_t i = 0; i < count; ++i)
+        {
+            characters += generate(sampler, rng, 0).size();
+        }
+        return Clock::now() - start;
+    };
+
+    size_t count = 256;
+    while (run(count) < MINIMUM_RUN_TIME)
+    {
+        count *= 2;
+    }
+
+    Clock::duration fastest = Clock::duration::max();
+    for (unsigned i = 0; i < RUN_COUNT; ++i)
+    {
+        fastest = std::min(fastest, run(count));
+    }
+
+    // The characters are counted only so that the words are not optimized away
+    volatile size_t sink = characters;
+    (void)sink;
+    return std::chrono::duration<double, std::nano>(fastest).count() / (double)count;
+}
+
+// Destroys the structures of the samplers not in use
+void TunedGenerator::release()
+{
+    if (sampler_ != Sampler::HIERARCHICAL)
+        hierarchical_.reset();
+    if (sampler_ != Sampler::SPARSE)
+        sparse_.reset();
+}
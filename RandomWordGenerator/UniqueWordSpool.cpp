@@ -0,0 +1,434 @@
+#include "UniqueWordSpool.h"
+
+#include "Fingerprint.h"
+#include "WordArena.h"
+#include "WordSort.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <system_error>
+
+namespace
+{
+    static char constexpr     CHECKPOINT_MAGIC[]    = "RWGU";
+    static int constexpr      CHECKPOINT_VERSION    = 1;
+    static size_t constexpr   READ_BLOCK_SIZE       = 1 << 20;
+    static unsigned constexpr SPLIT_COUNT           = 16;   // Number of pieces a partition is split into if it is too large
+    static unsigned constexpr MAX_SPLIT_LEVEL       = 6;
+    static uint64_t constexpr COMPACTION_OVERHEAD   = 4;    // Memory needed to compact a partition, per byte of the partition
+
+    // Returns the partition of a word with the given fingerprint at a level of splitting
+    unsigned partitionOf(uint64_t fingerprint, unsigned level, unsigned count)
+    {
+        uint64_t h = fingerprint;
+        if (level > 0)
+            h = WordFingerprint::mix(h + level * 0x9e3779b97f4a7c15ull);
+        return (unsigned)(((h >> 32) * count) >> 32);
+    }
+
+    // Calls a function with each line of a file. Returns false if the file cannot be read or the function returns false.
+    template <typename Function>
+    bool forEachLine(std::string const & name, Function f)
+    {
+        std::FILE * file = std::fopen(name.c_str(), "rb");
+        if (!file)
+            return false;
+
+        std::vector<char> block(READ_BLOCK_SIZE);
+        size_t            carried = 0;
+        bool              ok      = true;
+        while (ok)
+        {
+            size_t n = std::fread(block.data() + carried, 1, block.size() - carried, file);
+            if (n == 0)
+            {
+                ok = !std::ferror(file) && (carried == 0 || f(std::string_view(block.data(), carried)));
+                break;
+            }
+
+            char const * p    = block.data();
+            char const * last = block.data() + carried + n;
+            for (char const * eol; ok && (eol = static_cast<char const *>(memchr(p, '\n', last - p))) != nullptr; p = eol + 1)
+            {
+                ok = f(std::string_view(p, eol - p));
+            }
+
+            carried = last - p;
+            memmove(block.data(), p, carried);
+            if (carried == block.size())
+                block.resize(block.size() * 2);
+        }
+        std::fclose(file);
+        return ok;
+    }
+
+    // Truncates a file to a size and then to the end of its last complete line
+    bool truncateToLine(std::string const & name, uint64_t size)
+    {
+        std::error_code error;
+        std::filesystem::resize_file(name, size, error);
+        if (error)
+            return false;
+
+        std::ifstream file(name, std::ios::binary);
+        char          block[4096];
+        uint64_t      end = size;
+        while (end > 0 && file)
+        {
+            size_t n = (size_t)std::min<uint64_t>(end, sizeof(block));
+            file.seekg((std::streamoff)(end - n));
+            if (!file.read(block, n))
+                return false;
+            size_t i = n;
+            while (i > 0 && block[i - 1] != '\n')
+            {
+                --i;
+            }
+            if (i > 0)
+            {
+                end = end - n + i;
+                break;
+            }
+            end -= n;
+        }
+        file.close();
+
+        if (end != size)
+            std::filesystem::resize_file(name, end, error);
+        return !error;
+    }
+}
+
+//! @param  options     Options
+UniqueWordSpool::UniqueWordSpool(Options const & options)
+    : options_(options)
+{
+    options_.partitionCount = std::max(options_.partitionCount, 1u);
+}
+
+UniqueWordSpool::~UniqueWordSpool()
+{
+    flush();
+    for (std::FILE * file : files_)
+    {
+        if (file)
+            std::fclose(file);
+    }
+}
+
+//! @param  directory   Directory containing the spill files and the checkpoint
+//! @param  resume      If true, the spool is restored from the checkpoint in the directory, if there is one
+//! @param  state       The state saved with the checkpoint, or empty if there is none (optional)
+//!
+//! @return     true if the spool was opened
+bool UniqueWordSpool::open(std::string const & directory, bool resume, std::string * state)
+{
+    directory_ = directory;
+    unsigned count = options_.partitionCount;
+    files_.assign(count, nullptr);
+    buffers_.assign(count, std::string());
+    sizes_.assign(count, 0);
+    counts_.assign(count, 0);
+    compacted_.assign(count, false);
+    buffered_ = 0;
+    if (state)
+        state->clear();
+
+    // Restore the checkpoint. The partitions are truncated to the sizes saved with it. A partition may have been compacted
+    // since then, in which case it may be smaller or its size may not be at the end of a line, so it is truncated to the
+    // last complete line. Words lost that way were generated after the checkpoint and are generated again, and any
+    // duplicates are removed by the next compaction.
+
+    bool restored = false;
+    if (resume)
+    {
+        std::ifstream in(checkpointName(), std::ios::binary);
+        std::string   magic;
+        int           version        = 0;
+        unsigned      partitionCount = 0;
+        if (in >> magic >> version >> partitionCount && magic == CHECKPOINT_MAGIC && version == CHECKPOINT_VERSION)
+        {
+            if (partitionCount != count)
+                return false;
+
+            for (unsigned i = 0; i < count; ++i)
+            {
+                in >> sizes_[i];
+            }
+            size_t stateSize = 0;
+            in >> stateSize;
+            in.get();
+            std::string saved(stateSize, '\0');
+            if (!in.read(&saved[0], stateSize))
+                return false;
+            if (state)
+                *state = std::move(saved);
+            restored = true;
+        }
+    }
+
+    for (unsigned i = 0; i < count; ++i)
+    {
+        std::string     name = partitionName(i);
+        std::error_code error;
+        if (restored)
+        {
+            uint64_t size = std::filesystem::exists(name, error) ? std::filesystem::file_size(name, error) : 0;
+            if (error || (size > 0 && !truncateToLine(name, std::min(size, sizes_[i]))))
+                return false;
+            sizes_[i] = size > 0 ? std::filesystem::file_size(name, error) : 0;
+        }
+        else
+        {
+            std::filesystem::remove(name, error);
+        }
+        files_[i] = std::fopen(name.c_str(), "ab");
+        if (!files_[i])
+            return false;
+    }
+    return true;
+}
+
+//! @param  word    Word to add
+//!
+//! @return     false if a spill file cannot be written
+bool UniqueWordSpool::add(std::string_view word)
+{
+    return add(word, WordFingerprint::of(word));
+}
+
+//! @param  word            Word to add
+//! @param  fingerprint     WordFingerprint of the word
+//!
+//! @return     false if a spill file cannot be written
+bool UniqueWordSpool::add(std::string_view word, uint64_t fingerprint)
+{
+    unsigned      p      = partitionOf(fingerprint, 0, options_.partitionCount);
+    std::string & buffer = buffers_[p];
+    buffer.append(word.data(), word.size());
+    buffer.push_back('\n');
+    sizes_[p]    += word.size() + 1;
+    buffered_    += word.size() + 1;
+    compacted_[p] = false;
+
+    // The buffers use up to a quarter of the budget, leaving the rest for the caller and for compaction
+    if (buffered_ > options_.memoryBudget / 4)
+        return flush();
+    return true;
+}
+
+//! @return     the number of unique words, or -1 if a partition cannot be compacted
+int64_t UniqueWordSpool::compact()
+{
+    if (!flush())
+        return -1;
+
+    int64_t total = 0;
+    for (unsigned i = 0; i < options_.partitionCount; ++i)
+    {
+        if (!compacted_[i])
+        {
+            std::fclose(files_[i]);
+            std::string name = partitionName(i);
+            bool        ok   = compactFile(name, sizes_[i], 0, counts_[i]);
+            files_[i]        = std::fopen(name.c_str(), "ab");
+            if (!ok || !files_[i])
+                return -1;
+
+            std::error_code error;
+            sizes_[i]     = std::filesystem::file_size(name, error);
+            compacted_[i] = true;
+        }
+        total += (int64_t)counts_[i];
+    }
+    return total;
+}
+
+//! @param  state   State to save with the checkpoint
+//!
+//! @return     false if the checkpoint cannot be written
+bool UniqueWordSpool::checkpoint(std::string_view state)
+{
+    if (!flush())
+        return false;
+
+    // The checkpoint is written to a temporary file and then renamed, so a crash leaves either the old or the new one
+    std::string name      = checkpointName();
+    std::string temporary = name + ".tmp";
+    {
+        std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+        out << CHECKPOINT_MAGIC << ' ' << CHECKPOINT_VERSION << ' ' << options_.partitionCount << '\n';
+        for (uint64_t size : sizes_)
+        {
+            out << size << '\n';
+        }
+        out << state.size() << '\n';
+        out.write(state.data(), state.size());
+        out.flush();
+        if (!out)
+            return false;
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temporary, name, error);
+    return !error;
+}
+
+//! @param  f       Function called with each unique word. Iteration stops if it returns false.
+//! @param  limit   Maximum number of words visited
+//!
+//! @return     false if a partition cannot be read
+bool UniqueWordSpool::forEach(std::function<bool(std::string_view word)> const & f, uint64_t limit) const
+{
+    uint64_t visited = 0;
+    bool     stopped = false;
+    for (unsigned i = 0; i < options_.partitionCount && visited < limit && !stopped; ++i)
+    {
+        bool ok = forEachLine(partitionName(i), [&](std::string_view word) {
+            if (visited >= limit || !f(word))
+            {
+                stopped = true;
+                return false;
+            }
+            ++visited;
+            return true;
+        });
+        if (!ok && !stopped)
+            return false;
+    }
+    return true;
+}
+
+void UniqueWordSpool::remove()
+{
+    for (unsigned i = 0; i < files_.size(); ++i)
+    {
+        if (files_[i])
+            std::fclose(files_[i]);
+        files_[i] = nullptr;
+        std::error_code error;
+        std::filesystem::remove(partitionName(i), error);
+    }
+    std::error_code error;
+    std::filesystem::remove(checkpointName(), error);
+    files_.clear();
+    buffers_.clear();
+    sizes_.clear();
+    counts_.clear();
+    compacted_.clear();
+    buffered_ = 0;
+}
+
+std::string UniqueWordSpool::partitionName(unsigned i) const
+{
+    char name[32];
+    snprintf(name, sizeof(name), "/partition.%04u", i);
+    return directory_ + name;
+}
+
+std::string UniqueWordSpool::checkpointName() const
+{
+    return directory_ + "/checkpoint";
+}
+
+bool UniqueWordSpool::flush()
+{
+    bool ok = true;
+    for (unsigned i = 0; i < files_.size(); ++i)
+    {
+        std::string & buffer = buffers_[i];
+        if (!buffer.empty())
+        {
+            ok = files_[i] && std::fwrite(buffer.data(), 1, buffer.size(), files_[i]) == buffer.size() && ok;
+            buffer.clear();
+        }
+        if (files_[i])
+            ok = std::fflush(files_[i]) == 0 && ok;
+    }
+    buffered_ = 0;
+    return ok;
+}
+
+//! @param  name    Name of the file
+//! @param  size    Size of the file
+//! @param  level   Number of times the words in the file have been split
+//! @param  count   Number of unique words in the file (returned)
+//!
+//! @return     false if the file cannot be compacted
+bool UniqueWordSpool::compactFile(std::string const & name, uint64_t size, unsigned level, uint64_t & count)
+{
+    // A file that is too large to compact in memory is split by a different hash into pieces that are compacted separately.
+    // Equal words are in the same piece, so the concatenation of the compacted pieces has no duplicates.
+
+    if (size * COMPACTION_OVERHEAD > options_.memoryBudget && level < MAX_SPLIT_LEVEL)
+    {
+        std::vector<std::string>  pieceNames;
+        std::vector<std::FILE *>  pieces;
+        std::vector<uint64_t>     pieceSizes(SPLIT_COUNT, 0);
+        bool                      ok = true;
+        for (unsigned i = 0; i < SPLIT_COUNT; ++i)
+        {
+            pieceNames.push_back(name + "." + std::to_string(i));
+            pieces.push_back(std::fopen(pieceNames.back().c_str(), "wb"));
+            ok = pieces.back() && ok;
+        }
+        ok = ok && forEachLine(name, [&](std::string_view word) {
+            unsigned p = partitionOf(WordFingerprint::of(word), level + 1, SPLIT_COUNT);
+            pieceSizes[p] += word.size() + 1;
+            return std::fwrite(word.data(), 1, word.size(), pieces[p]) == word.size() && std::fputc('\n', pieces[p]) != EOF;
+        });
+        for (std::FILE * piece : pieces)
+        {
+            if (piece)
+                ok = std::fclose(piece) == 0 && ok;
+        }
+
+        // Compact each piece and append it to the new file
+
+        std::string temporary = name + ".tmp";
+        std::FILE * out       = ok ? std::fopen(temporary.c_str(), "wb") : nullptr;
+        count = 0;
+        for (unsigned i = 0; i < SPLIT_COUNT; ++i)
+        {
+            uint64_t pieceCount = 0;
+            ok = ok && out && compactFile(pieceNames[i], pieceSizes[i], level + 1, pieceCount);
+            ok = ok && forEachLine(pieceNames[i], [&](std::string_view word) {
+                return std::fwrite(word.data(), 1, word.size(), out) == word.size() && std::fputc('\n', out) != EOF;
+            });
+            count += pieceCount;
+            std::error_code error;
+            std::filesystem::remove(pieceNames[i], error);
+        }
+        if (out)
+            ok = std::fclose(out) == 0 && ok;
+
+        std::error_code error;
+        if (ok)
+            std::filesystem::rename(temporary, name, error);
+        return ok && !error;
+    }
+
+    WordArena arena;
+    arena.reserve((size_t)(size / 8), (size_t)size);
+    if (!forEachLine(name, [&](std::string_view word) { arena.add(word); return true; }))
+        return false;
+
+    std::vector<uint32_t> order = sortWords(arena, true, options_.threadCount);
+    count = order.size();
+
+    std::string temporary = name + ".tmp";
+    {
+        std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+        if (!writeWords(arena, order, out))
+            return false;
+        out.flush();
+        if (!out)
+            return false;
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temporary, name, error);
+    return !error;
+}
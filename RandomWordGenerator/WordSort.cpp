@@ -0,0 +1,297 @@
+#include "WordSort.h"
+
+#include "WordArena.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+
+// The words are sorted with a most-significant-digit radix sort. Since words are almost always made of lower case letters,
+// each level distributes the words into 29 buckets: the end of the word, every character less than 'a', one bucket for
+// each of 'a' through 'z', and every character greater than 'z'. The two catch-all buckets are finished with a comparison
+// sort. All words in the end-of-word bucket are equal, so duplicates are found without any comparisons.
+
+namespace
+{
+    size_t constexpr BUCKET_COUNT   = 29;
+    size_t constexpr END            = 0;
+    size_t constexpr BELOW          = 1;
+    size_t constexpr ABOVE          = 28;
+    size_t constexpr SMALL_RANGE    = 32;           // Ranges smaller than this are sorted by comparison
+    size_t constexpr TASK_THRESHOLD = 1 << 14;      // Buckets larger than this are sorted by any available thread
+    size_t constexpr OUTPUT_BUFFER  = 1 << 20;
+
+    class Sorter
+    {
+    public:
+        Sorter(WordArena const & arena, bool unique)
+            : arena_(arena)
+            , unique_(unique)
+            , index_(arena.size())
+            , temp_(arena.size())
+            , buckets_(arena.size())
+            , duplicate_(arena.size(), 0)
+        {
+        }
+
+        std::vector<uint32_t> sort(unsigned threadCount)
+        {
+            size_t n = index_.size();
+            threadCount = (unsigned)std::max<size_t>(1, std::min<size_t>(threadCount, n / TASK_THRESHOLD + 1));
+
+            // Distribute the words by their first character in parallel. Each thread counts its own part, and then
+            // scatters it to its own region within each bucket.
+            std::vector<size_t>      counts(threadCount * BUCKET_COUNT, 0);
+            std::vector<std::thread> workers;
+            auto                     part = [n, threadCount](unsigned t) { return n * t / threadCount; };
+            for (unsigned t = 0; t < threadCount; ++t)
+            {
+                workers.emplace_back([&, t] {
+                    size_t * c = &counts[t * BUCKET_COUNT];
+                    for (size_t i = part(t); i < part(t + 1); ++i)
+                    {
+                        buckets_[i] = bucket(arena_[i], 0);
+                        ++c[buckets_[i]];
+                    }
+                });
+            }
+            join(workers);
+
+            std::vector<size_t> bucketStarts(BUCKET_COUNT + 1, 0);
+            size_t              position = 0;
+            for (size_t b = 0; b < BUCKET_COUNT; ++b)
+            {
+                bucketStarts[b] = position;
+                for (unsigned t = 0; t < threadCount; ++t)
+                {
+                    size_t count                = counts[t * BUCKET_COUNT + b];
+                    counts[t * BUCKET_COUNT + b] = position;
+                    position                   += count;
+                }
+            }
+            bucketStarts[BUCKET_COUNT] = position;
+
+            for (unsigned t = 0; t < threadCount; ++t)
+            {
+                workers.emplace_back([&, t] {
+                    size_t * next = &counts[t * BUCKET_COUNT];
+                    for (size_t i = part(t); i < part(t + 1); ++i)
+                    {
+                        index_[next[buckets_[i]]++] = (uint32_t)i;
+                    }
+                });
+            }
+            join(workers);
+
+            for (size_t b = 0; b < BUCKET_COUNT; ++b)
+            {
+                finishBucket(b, bucketStarts[b], bucketStarts[b + 1], 0, true);
+            }
+
+            // Sort the remaining buckets in parallel
+            for (unsigned t = 0; t < threadCount; ++t)
+            {
+                workers.emplace_back([this] { work(); });
+            }
+            join(workers);
+
+            // Drop the duplicates
+            std::vector<uint32_t> result;
+            result.reserve(n);
+            for (size_t i = 0; i < n; ++i)
+            {
+                if (!duplicate_[i])
+                    result.push_back(index_[i]);
+            }
+            return result;
+        }
+
+    private:
+        struct Task
+        {
+            size_t begin;
+            size_t end;
+            size_t depth;
+            bool   compare;     // Sort by comparison rather than by distribution
+        };
+
+        static size_t bucket(std::string_view word, size_t depth)
+        {
+            if (depth >= word.size())
+                return END;
+            uint8_t c = (uint8_t)word[depth];
+            if (c < 'a')
+                return BELOW;
+            if (c > 'z')
+                return ABOVE;
+            return 2 + (c - 'a');
+        }
+
+        static void join(std::vector<std::thread> & workers)
+        {
+            for (auto & worker : workers)
+            {
+                worker.join();
+            }
+            workers.clear();
+        }
+
+        void work()
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            while (true)
+            {
+                ready_.wait(lock, [this] { return !tasks_.empty() || active_ == 0; });
+                if (tasks_.empty())
+                    break;
+
+                Task task = tasks_.back();
+                tasks_.pop_back();
+                ++active_;
+                lock.unlock();
+
+                if (task.compare)
+                    compareSort(task.begin, task.end, task.depth);
+                else
+                    sortRange(task.begin, task.end, task.depth);
+
+                lock.lock();
+                --active_;
+                if (active_ == 0 && tasks_.empty())
+                    ready_.notify_all();
+            }
+            ready_.notify_all();
+        }
+
+        // Sorts the words in [begin, end), which all share their first depth characters
+        void sortRange(size_t begin, size_t end, size_t depth)
+        {
+            if (end - begin < SMALL_RANGE)
+            {
+                compareSort(begin, end, depth);
+                return;
+            }
+
+            size_t counts[BUCKET_COUNT] = {};
+            for (size_t i = begin; i < end; ++i)
+            {
+                buckets_[i] = (uint8_t)bucket(arena_[index_[i]], depth);
+                ++counts[buckets_[i]];
+            }
+
+            size_t starts[BUCKET_COUNT + 1];
+            size_t next[BUCKET_COUNT];
+            starts[0] = begin;
+            for (size_t b = 0; b < BUCKET_COUNT; ++b)
+            {
+                next[b]       = starts[b];
+                starts[b + 1] = starts[b] + counts[b];
+            }
+            for (size_t i = begin; i < end; ++i)
+            {
+                temp_[next[buckets_[i]]++] = index_[i];
+            }
+            std::copy(temp_.begin() + begin, temp_.begin() + end, index_.begin() + begin);
+
+            for (size_t b = 0; b < BUCKET_COUNT; ++b)
+            {
+                finishBucket(b, starts[b], starts[b + 1], depth, false);
+            }
+        }
+
+        // Finishes a bucket containing the words in [begin, end) that share their first depth characters
+        void finishBucket(size_t b, size_t begin, size_t end, size_t depth, bool queue)
+        {
+            if (end - begin < 2)
+                return;
+
+            if (b == END)
+            {
+                if (unique_)
+                    std::fill(duplicate_.begin() + begin + 1, duplicate_.begin() + end, 1);
+            }
+            else if (queue || end - begin >= TASK_THRESHOLD)
+            {
+                bool                        compare = (b == BELOW || b == ABOVE);
+                std::lock_guard<std::mutex> lock(mutex_);
+                tasks_.push_back({ begin, end, compare ? depth : depth + 1, compare });
+                ready_.notify_one();
+            }
+            else if (b == BELOW || b == ABOVE)
+            {
+                compareSort(begin, end, depth);
+            }
+            else
+            {
+                sortRange(begin, end, depth + 1);
+            }
+        }
+
+        void compareSort(size_t begin, size_t end, size_t depth)
+        {
+            auto suffix = [this, depth](uint32_t i) { return arena_[i].substr(std::min(depth, arena_[i].size())); };
+            std::sort(index_.begin() + begin, index_.begin() + end, [&suffix](uint32_t a, uint32_t b) { return suffix(a) < suffix(b); });
+            if (unique_)
+            {
+                for (size_t i = begin + 1; i < end; ++i)
+                {
+                    duplicate_[i] = (suffix(index_[i]) == suffix(index_[i - 1]));
+                }
+            }
+        }
+
+        WordArena const &       arena_;
+        bool                    unique_;
+        std::vector<uint32_t>   index_;
+        std::vector<uint32_t>   temp_;
+        std::vector<uint8_t>    buckets_;
+        std::vector<uint8_t>    duplicate_;
+        std::mutex              mutex_;
+        std::condition_variable ready_;
+        std::vector<Task>       tasks_;
+        int                     active_ = 0;
+    };
+}
+
+//! @param  arena           Words to sort. There must be fewer than 2^32 words.
+//! @param  unique          If true, only the first of a run of equal words is returned
+//! @param  threadCount     Number of threads to use, or 0 to use one per hardware thread
+//!
+//! @return     The indexes of the words in order
+
+std::vector<uint32_t> sortWords(WordArena const & arena, bool unique /*= true*/, unsigned threadCount /*= 0*/)
+{
+    if (threadCount == 0)
+        threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+
+    Sorter sorter(arena, unique);
+    return sorter.sort(threadCount);
+}
+
+//! @param  arena   Words to write
+//! @param  order   Indexes of the words to write, in the order they are written
+//! @param  out     Destination
+//!
+//! @return     false if the words could not be written
+
+bool writeWords(WordArena const & arena, std::vector<uint32_t> const & order, std::ostream & out)
+{
+    std::string buffer;
+    buffer.reserve(OUTPUT_BUFFER + 256);
+    for (uint32_t i : order)
+    {
+        std::string_view word = arena[i];
+        buffer.append(word.data(), word.size());
+        buffer.push_back('\n');
+        if (buffer.size() >= OUTPUT_BUFFER)
+        {
+            out.write(buffer.data(), buffer.size());
+            buffer.clear();
+        }
+    }
+    out.write(buffer.data(), buffer.size());
+    return (bool)out;
+}
@@ -0,0 +1,59 @@
+#if !defined(RANDOMWORDGENERATOR_BINARYFUSEFILTER_H)
+#define RANDOMWORDGENERATOR_BINARYFUSEFILTER_H
+
+#pragma once
+
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <RandomWordGenerator/Filter.h>
+#include <RandomWordGenerator/MappedFile.h>
+
+class SortedWordSet;
+
+//! An immutable approximate set of words stored in a memory-mapped file.
+//!
+//! This is a 3-wise binary fuse filter with 8-bit fingerprints (Graf and Lemire, 2022). It uses about 9 bits per word and
+//! reports a word that is not in the set as present with a probability of about 0.4%. A word in the set is always reported
+//! as present.
+class BinaryFuseFilter : public RandomWordFilter
+{
+public:
+    //! Writes a filter containing the words.
+    static bool write(std::vector<std::string> const & words, std::ostream & out);
+
+    //! Maps a filter written by write(). Returns false if the file cannot be mapped or is not a valid filter.
+    bool open(char const * filename);
+
+    //! Sets an exact set used to confirm the words found in the filter, or nullptr to accept them unconfirmed.
+    void setConfirmation(SortedWordSet const * exact) { confirmation_ = exact; }
+
+    //! Returns true if the word may be in the set, or false if it is definitely not in the set.
+    bool mayContain(std::string_view word) const;
+
+    //! Rejects words that may be in the set, or that are in the confirmation set if there is one.
+    bool rejects(std::string_view word) override;
+
+private:
+    struct Layout
+    {
+        uint64_t seed;
+        uint32_t segmentLength;
+        uint32_t segmentLengthMask;
+        uint32_t segmentCount;
+        uint32_t segmentCountLength;
+        uint32_t arrayLength;
+    };
+
+    static void positions(Layout const & layout, uint64_t hash, uint32_t h[3]);
+
+    MappedFile              file_;
+    Layout                  layout_       = {};
+    uint8_t const *         fingerprints_ = nullptr;
+    SortedWordSet const *   confirmation_ = nullptr;
+};
+
+#endif // !defined(RANDOMWORDGENERATOR_BINARYFUSEFILTER_H)
@@ -0,0 +1,154 @@
+#if !defined(RANDOMWORDGENERATOR_BOUNDEDQUEUE_H)
+#define RANDOMWORDGENERATOR_BOUNDEDQUEUE_H
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+
+//! A fixed-capacity lock-free queue for any number of producers and consumers.
+//!
+//! This is Dmitry Vyukov's bounded MPMC queue. Each cell carries a sequence number that tells producers and consumers
+//! whether it is ready for them, so an operation costs one compare-and-swap on the shared position in the common case.
+//! push() and pop() wait (spinning briefly, then yielding, then sleeping) when the queue is full or empty, which is what propagates
+//! backpressure from a slow consumer to its producers.
+template <typename T>
+class BoundedQueue
+{
+public:
+    //! Constructor. The capacity is rounded up to a power of two.
+    explicit BoundedQueue(size_t capacity)
+    {
+        size_t n = 2;
+        while (n < capacity)
+        {
+            n *= 2;
+        }
+        mask_  = n - 1;
+        cells_ = std::make_unique<Cell[]>(n);
+        for (size_t i = 0; i < n; ++i)
+        {
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    BoundedQueue(BoundedQueue const &) = delete;
+    BoundedQueue & operator =(BoundedQueue const &) = delete;
+
+    //! Adds a value if there is room. Returns false if the queue is full.
+    bool tryPush(T value)
+    {
+        size_t position = enqueuePosition_.load(std::memory_order_relaxed);
+        Cell * cell;
+        while (true)
+        {
+            cell = &cells_[position & mask_];
+            size_t   sequence   = cell->sequence.load(std::memory_order_acquire);
+            intptr_t difference = (intptr_t)sequence - (intptr_t)position;
+            if (difference == 0)
+            {
+                if (enqueuePosition_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if (difference < 0)
+            {
+                return false;
+            }
+            else
+            {
+                position = enqueuePosition_.load(std::memory_order_relaxed);
+            }
+        }
+        cell->value = std::move(value);
+        cell->sequence.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    //! Removes a value if there is one. Returns false if the queue is empty.
+    bool tryPop(T & value)
+    {
+        size_t position = dequeuePosition_.load(std::memory_order_relaxed);
+        Cell * cell;
+        while (true)
+        {
+            cell = &cells_[position & mask_];
+            size_t   sequence   = cell->sequence.load(std::memory_order_acquire);
+            intptr_t difference = (intptr_t)sequence - (intptr_t)(position + 1);
+            if (difference == 0)
+            {
+                if (dequeuePosition_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if (difference < 0)
+            {
+                return false;
+            }
+            else
+            {
+                position = dequeuePosition_.load(std::memory_order_relaxed);
+            }
+        }
+        value = std::move(cell->value);
+        cell->sequence.store(position + mask_ + 1, std::memory_order_release);
+        return true;
+    }
+
+    //! Adds a value, waiting for room if necessary.
+    void push(T value)
+    {
+        for (int spin = 0; !tryPush(value); ++spin)
+        {
+            wait(spin);
+        }
+    }
+
+    //! Removes a value, waiting for one if necessary.
+    T pop()
+    {
+        T value;
+        for (int spin = 0; !tryPop(value); ++spin)
+        {
+            wait(spin);
+        }
+        return value;
+    }
+
+    //! Returns the approximate number of values in the queue.
+    size_t size() const
+    {
+        size_t enqueued = enqueuePosition_.load(std::memory_order_relaxed);
+        size_t dequeued = dequeuePosition_.load(std::memory_order_relaxed);
+        return (enqueued > dequeued) ? enqueued - dequeued : 0;
+    }
+
+    //! Returns the capacity of the queue.
+    size_t capacity() const { return mask_ + 1; }
+
+private:
+    static size_t constexpr CACHE_LINE_SIZE = 64;
+
+    struct Cell
+    {
+        std::atomic<size_t> sequence;
+        T                   value;
+    };
+
+    static void wait(int spin)
+    {
+        if (spin >= 1024)
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        else if (spin >= 64)
+            std::this_thread::yield();
+    }
+
+    std::unique_ptr<Cell[]> cells_;
+    size_t                  mask_;
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> enqueuePosition_{ 0 };
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> dequeuePosition_{ 0 };
+};
+
+#endif // !defined(RANDOMWORDGENERATOR_BOUNDEDQUEUE_H)
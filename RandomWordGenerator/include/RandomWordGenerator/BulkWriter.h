@@ -0,0 +1,135 @@
+#if !defined(RANDOMWORDGENERATOR_BULKWRITER_H)
+#define RANDOMWORDGENERATOR_BULKWRITER_H
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+//! Writes large amounts of data to a file from many threads.
+//!
+//! Producers fill fixed-size buffers with whole records and submit them. Each submitted buffer is written at the next free
+//! offset of the file while the producer fills another one, so a record is never split, but the buffers of different
+//! producers are interleaved in the order they are submitted. On Linux the writes are queued with io_uring using registered
+//! buffers. Otherwise, or if io_uring is not available, each buffer is written with pwritev by the thread that submits it.
+//!
+//! Writing directly (O_DIRECT) requires every write to be aligned, so in that mode submitted buffers are packed into a
+//! separate set of aligned staging buffers, and only full staging buffers are written until the file is closed.
+class BulkWriter
+{
+public:
+    struct Options
+    {
+        size_t   bufferSize  = 1 << 20;     //!< Size of each buffer. Rounded up to a multiple of 4096 if direct is set.
+        unsigned bufferCount = 16;          //!< Number of buffers filled by producers.
+        unsigned queueDepth  = 8;           //!< Number of staging buffers, and so writes in flight, if direct is set.
+        bool     direct      = false;       //!< Bypass the page cache (O_DIRECT) where supported.
+    };
+
+    //! A buffer being filled by a producer.
+    struct Buffer
+    {
+        char *   data;
+        size_t   size;
+        size_t   capacity;
+        unsigned index;
+        uint64_t offset;    // Offset in the file of the data not yet written
+        size_t   pending;   // Amount of data not yet written
+    };
+
+    //! Fills buffers from a single thread. A buffer is written as soon as the next record does not fit, while the next one
+    //! is filled.
+    class Stream
+    {
+    public:
+        //! Constructor.
+        explicit Stream(BulkWriter & writer)
+            : writer_(writer)
+        {
+        }
+
+        //! Destructor. Submits any buffered data.
+        ~Stream() { flush(); }
+
+        Stream(Stream const &) = delete;
+        Stream & operator =(Stream const &) = delete;
+
+        //! Appends data to the current record. Returns false if the record does not fit in a buffer or a write failed.
+        bool write(std::string_view data);
+
+        //! Appends a character to the current record.
+        bool put(char c) { return write(std::string_view(&c, 1)); }
+
+        //! Ends the current record.
+        void endRecord() { recordStart_ = buffer_ ? buffer_->size : 0; }
+
+        //! Submits any buffered data.
+        bool flush();
+
+    private:
+        BulkWriter & writer_;
+        Buffer *     buffer_      = nullptr;
+        size_t       recordStart_ = 0;
+        std::string  carry_;
+    };
+
+    //! Constructor.
+    BulkWriter();
+
+    //! Destructor. Closes the file.
+    ~BulkWriter();
+
+    BulkWriter(BulkWriter const &) = delete;
+    BulkWriter & operator =(BulkWriter const &) = delete;
+
+    //! Creates or truncates the file. Returns false if it cannot be opened.
+    bool open(char const * filename, Options const & options);
+
+    //! Waits for all writes to complete and closes the file. Returns false if any write failed.
+    bool close();
+
+    //! Returns an empty buffer, waiting for one if necessary.
+    Buffer * acquire();
+
+    //! Writes the contents of a buffer. The buffer must not be used again until it is acquired again.
+    bool submit(Buffer * buffer);
+
+    //! Returns true if the writes are queued with io_uring.
+    bool usingIoUring() const { return ring_ != nullptr; }
+
+private:
+    struct Ring;
+
+    void release(Buffer * buffer);
+    void stage(Buffer * buffer);
+    bool writeAt(char const * data, size_t size, uint64_t offset, int fd);
+    void writeTail();
+    void reap(bool wait);
+    void queue(Buffer * buffer);
+
+    Options                 options_;
+    int                     fd_          = -1;
+    char *                  memory_      = nullptr;
+    std::vector<Buffer>     buffers_;
+    std::vector<Buffer *>   free_;
+    std::vector<Buffer *>   freeStages_;
+    Buffer *                stage_       = nullptr;     // Staging buffer being filled when writing directly
+    std::unique_ptr<Ring>   ring_;
+    std::atomic<uint64_t>   nextOffset_;
+    std::atomic<unsigned>   inFlight_;
+    std::atomic<bool>       failed_;
+    std::mutex              freeMutex_;
+    std::condition_variable freeReady_;
+    std::mutex              stageMutex_;
+    std::mutex              submitMutex_;
+    std::mutex              reapMutex_;
+    std::string             filename_;
+};
+
+#endif // !defined(RANDOMWORDGENERATOR_BULKWRITER_H)
@@ -0,0 +1,59 @@
+#if !defined(RANDOMWORDGENERATOR_CODEC_H)
+#define RANDOMWORDGENERATOR_CODEC_H
+
+#pragma once
+
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+class RandomWordGenerator;
+
+//! Compresses lists of words by entropy coding each character with the probabilities of a RandomWordGenerator.
+//!
+//! Words are coded in independent blocks so that the blocks of a stream can be decoded in parallel. Words containing
+//! characters that are not in the alphabet are stored verbatim behind an escape symbol.
+class RandomWordCodec
+{
+public:
+    static size_t constexpr DEFAULT_BLOCK_SIZE = 4096;  //!< Default number of words per block.
+
+    //! Constructor.
+    explicit RandomWordCodec(RandomWordGenerator const & generator);
+
+    //! Encodes a block of words, replacing the contents of @a payload.
+    void encodeBlock(std::vector<std::string> const & words, std::vector<uint8_t> & payload) const;
+
+    //! Decodes a block of @a count words, appending them to @a words.
+    bool decodeBlock(uint8_t const * payload, size_t size, size_t count, std::vector<std::string> & words) const;
+
+    //! Encodes a stream of words, one per line.
+    bool encode(std::istream & in, std::ostream & out, size_t blockSize = DEFAULT_BLOCK_SIZE) const;
+
+    //! Decodes a stream into words, one per line.
+    bool decode(std::istream & in, std::ostream & out, unsigned threadCount = 0) const;
+
+    //! Returns a checksum of the coding tables. Streams can only be decoded by a codec with the same checksum.
+    uint64_t checksum() const { return checksum_; }
+
+private:
+    static size_t constexpr ESCAPE       = 27;              // Index of the escape symbol
+    static size_t constexpr SYMBOL_COUNT = 28;              // Characters, terminator, and escape
+    static int constexpr    SCALE_BITS   = 16;              // Precision of the integer CDFs
+    static uint32_t constexpr TOTAL      = 1u << SCALE_BITS;
+
+    struct Symbol
+    {
+        uint32_t start;
+        uint32_t frequency;
+    };
+
+    uint32_t const * row(size_t i0, size_t i1, size_t i2) const;
+    void             addWord(std::string const & word, std::vector<Symbol> & symbols) const;
+
+    std::vector<uint32_t> cumulative_;  // SYMBOL_COUNT + 1 entries per context
+    uint64_t              checksum_;
+};
+
+#endif // !defined(RANDOMWORDGENERATOR_CODEC_H)
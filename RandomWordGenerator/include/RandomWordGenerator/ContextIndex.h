@@ -0,0 +1,89 @@
+#if !defined(RANDOMWORDGENERATOR_CONTEXTINDEX_H)
+#define RANDOMWORDGENERATOR_CONTEXTINDEX_H
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <RandomWordGenerator/Fingerprint.h>
+
+//! Maps a fixed set of context keys to the rows [0, n) of a sparse table, with no collisions and no gaps.
+//!
+//! This is a minimal perfect hash function in the style of PTHash (Pibiri and Trani, 2021). The keys are hashed into
+//! buckets, with 60% of them going to 30% of the buckets, and each bucket has a 16-bit pilot, found at build time, that
+//! moves its keys to free positions. Positions beyond n are remapped to the free rows below n. The pilots take about
+//! 4 bits per key, and the remap table a fraction of a bit.
+//!
+//! A lookup hashes the key, reads the pilot of its bucket, and reads an 8-bit fingerprint of the key stored at its row,
+//! which are usually the only two cache misses. A key that is not in the set is detected by the fingerprint, except
+//! with a probability of 1/256. Callers that must be exact should confirm the key in the row itself.
+class ContextIndex
+{
+public:
+    static size_t constexpr NOT_FOUND = ~(size_t)0;     //!< Returned by find() for a key that is not in the set
+
+    //! Builds the index for a set of distinct keys. Returns false if the keys are not distinct or the index cannot be
+    //! built.
+    bool build(std::vector<uint64_t> const & keys);
+
+    //! Returns the row of a key, or NOT_FOUND if the key is not in the set.
+    size_t find(uint64_t key) const
+    {
+        if (size_ == 0)
+            return NOT_FOUND;
+        uint64_t hash = hashKey(key);
+        size_t   row  = position(hash);
+        return (fingerprints_[row] == fingerprint(hash)) ? row : NOT_FOUND;
+    }
+
+    //! Returns the row of a key that is known to be in the set. The result is meaningless for any other key.
+    size_t row(uint64_t key) const { return position(hashKey(key)); }
+
+    //! Returns the number of keys.
+    size_t size() const { return size_; }
+
+    //! Returns the size of the index, in bytes.
+    size_t memorySize() const;
+
+private:
+    uint64_t hashKey(uint64_t key) const { return WordFingerprint::mix(key + seed_); }
+
+    size_t bucket(uint64_t hash) const
+    {
+        // 60% of the keys go to the first 30% of the buckets, which are filled first while there is the most room
+        uint64_t h = hash >> 32;
+        return ((uint32_t)hash < DENSE_FRACTION) ? (size_t)((h * denseBucketCount_) >> 32)
+                                                 : denseBucketCount_ + (size_t)((h * (bucketCount_ - denseBucketCount_)) >> 32);
+    }
+
+    // Returns the position of a key in the table for a pilot, which may be beyond the last row
+    size_t place(uint64_t hash, uint16_t pilot) const
+    {
+        uint64_t p = WordFingerprint::mix(hash ^ pilotHash(pilot));
+        return (size_t)((p >> 32) * tableSize_ >> 32);
+    }
+
+    size_t position(uint64_t hash) const
+    {
+        size_t i = place(hash, pilots_[bucket(hash)]);
+        return (i < size_) ? i : remap_[i - size_];
+    }
+
+    static uint64_t pilotHash(uint16_t pilot) { return (pilot + 1) * 0x9e3779b97f4a7c15ull; }
+    static uint8_t  fingerprint(uint64_t hash) { return (uint8_t)(hash >> 8); }
+
+    static uint32_t constexpr DENSE_FRACTION = 0x9999999au;     // 0.6 * 2^32
+
+    uint64_t              seed_             = 0;
+    size_t                size_             = 0;
+    size_t                tableSize_        = 0;    // Number of positions, a little more than the number of keys
+    size_t                bucketCount_      = 0;
+    size_t                denseBucketCount_ = 0;
+    std::vector<uint16_t> pilots_;
+    std::vector<uint32_t> remap_;                   // Row of each position beyond the last row
+    std::vector<uint8_t>  fingerprints_;
+};
+
+#endif // !defined(RANDOMWORDGENERATOR_CONTEXTINDEX_H)
@@ -0,0 +1,33 @@
+#if !defined(RANDOMWORDGENERATOR_CORPUS_H)
+#define RANDOMWORDGENERATOR_CORPUS_H
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+//! A list of words and their relative frequencies, loaded once and shared by any number of factories.
+class RandomWordCorpus
+{
+public:
+    //! Loads a distribution file. Returns false if the file cannot be read.
+    bool load(char const * filename);
+
+    //! Adds a word to the corpus. The word is converted to lower case.
+    void add(std::string word, float frequency = 1.0f);
+
+    //! Returns the number of words in the corpus.
+    size_t size() const { return words_.size(); }
+
+    //! Returns the word at the given index.
+    std::string const & word(size_t i) const { return words_[i]; }
+
+    //! Returns the frequency of the word at the given index.
+    float frequency(size_t i) const { return frequencies_[i]; }
+
+private:
+    std::vector<std::string> words_;
+    std::vector<float>       frequencies_;
+};
+
+#endif // !defined(RANDOMWORDGENERATOR_CORPUS_H)
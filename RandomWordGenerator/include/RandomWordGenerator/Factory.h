@@ -3,11 +3,16 @@
 
 #pragma once
 
+#include <cstdint>
 #include <memory>
 #include <iosfwd>
+#include <vector>
 
 #include <RandomWordGenerator/Generator.h>
 
+class RandomWordCorpus;
+class SparseGenerator;
+
 class RandomWordGeneratorFactory
 {
 public:
@@ -20,18 +25,59 @@ public:
     //! Adds words from the text to the distribution table.
     bool analyzeText( char const * text, float factor = 1.0f );
 
+    //! Adds the words in the corpus to the distribution table, weighted by their frequencies or, if unweighted, equally.
+    bool analyzeCorpus( RandomWordCorpus const & corpus, bool unweighted = false );
+
+    //! Trains a RandomWordGenerator from a distribution file. Returns nullptr if the file cannot be loaded.
+    static std::shared_ptr<RandomWordGenerator> train( char const * filename, bool unweighted = false );
+
+    //! Multiplies every frequency in the distribution table by a factor in (0, 1], in constant time.
+    void decay( float factor );
+
+    //! Sets the pseudo-count added to every character of an observed context.
+    void setSmoothing( float smoothing );
+
+    //! Sets the frequency below which an observed transition is discarded.
+    void setPruningThreshold( float threshold );
+
+    //! Sets the number of bits to which CDF values are quantized (0 means no quantization).
+    void setQuantization( int bits );
+
     //! Creates a RandomWordGenerator from the distribution data.
     std::shared_ptr<RandomWordGenerator> create();
 
+    //! Creates a SparseGenerator, which stores only the observed contexts, from the distribution data.
+    std::shared_ptr<SparseGenerator> createSparse();
+
+    //! Updates a generator created by this factory with the rows of the distribution data changed since it was created or
+    //! last updated.
+    void update( RandomWordGenerator & generator );
+
 private:
     friend std::ostream & operator<<( std::ostream & s, RandomWordGeneratorFactory const & data );
     friend std::istream & operator>>( std::istream & s, RandomWordGeneratorFactory & data );
 
     void finalize();
+    void finalizeRow( size_t i, size_t j, size_t k );
+    void markDirty( size_t i, size_t j, size_t k );
+    void markAllDirty();
+    void renormalize();
+
+    // The frequencies are stored multiplied by weight_, which decay() divides by the factor instead of multiplying every
+    // frequency. New observations are added multiplied by weight_, and the table is renormalized when weight_ grows large.
 
     float (*frequencies_)[RandomWordGenerator::ALPHABET_SIZE + 1][RandomWordGenerator::ALPHABET_SIZE + 1][RandomWordGenerator::ALPHABET_SIZE + 1];
     float (*cdfs_)[RandomWordGenerator::ALPHABET_SIZE + 1][RandomWordGenerator::ALPHABET_SIZE + 1][RandomWordGenerator::ALPHABET_SIZE + 1];
-    bool  finalized_ = false;
+    float smoothing_        = 0.0f;
+    float pruningThreshold_ = 0.0f;
+    int   quantization_     = 0;
+    bool  finalized_        = false;
+    float weight_           = 1.0f;
+
+    // Rows whose CDFs must be recomputed
+    std::vector<uint32_t> dirtyRows_;
+    std::vector<bool>     isDirty_;
+    bool                  allDirty_ = true;
 };
 
 //! Inserts a RandomWordGeneratorFactory into a stream.
@@ -0,0 +1,19 @@
+#if !defined(RANDOMWORDGENERATOR_FILTER_H)
+#define RANDOMWORDGENERATOR_FILTER_H
+
+#pragma once
+
+#include <string_view>
+
+//! Decides whether a generated word may be issued.
+class RandomWordFilter
+{
+public:
+    //! Destructor.
+    virtual ~RandomWordFilter() = default;
+
+    //! Returns true if the word must not be issued.
+    virtual bool rejects(std::string_view word) = 0;
+};
+
+#endif // !defined(RANDOMWORDGENERATOR_FILTER_H)
@@ -0,0 +1,67 @@
+#if !defined(RANDOMWORDGENERATOR_FINGERPRINT_H)
+#define RANDOMWORDGENERATOR_FINGERPRINT_H
+
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+//! A 64-bit fingerprint of a word, computed one character at a time.
+//!
+//! A generator can append each character to the fingerprint as it emits it, so the stages that deduplicate, filter, or
+//! partition the words can use the fingerprint instead of hashing each word again. The fingerprint of a word does not
+//! depend on how it was computed, so WordFingerprint::of() gives the same value for the finished word.
+class WordFingerprint
+{
+public:
+    //! Appends a character.
+    void append(char c)
+    {
+        state_ = state_ * 0x100000001b3ull + (uint8_t)c + 1;
+        ++length_;
+    }
+
+    //! Appends the characters of a string.
+    void append(std::string_view s)
+    {
+        for (char c : s)
+        {
+            append(c);
+        }
+    }
+
+    //! Returns the fingerprint of the characters appended so far.
+    uint64_t value() const { return mix(state_ ^ length_); }
+
+    //! Forgets the characters appended so far.
+    void clear()
+    {
+        state_  = 0;
+        length_ = 0;
+    }
+
+    //! Returns the fingerprint of a word.
+    static uint64_t of(std::string_view word)
+    {
+        WordFingerprint fingerprint;
+        fingerprint.append(word);
+        return fingerprint.value();
+    }
+
+    //! Returns a well-distributed 64-bit hash of a 64-bit value (the finalizer of MurmurHash3). It is a bijection.
+    static uint64_t mix(uint64_t h)
+    {
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdull;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ull;
+        h ^= h >> 33;
+        return h;
+    }
+
+private:
+    uint64_t state_  = 0;
+    uint64_t length_ = 0;
+};
+
+#endif // !defined(RANDOMWORDGENERATOR_FINGERPRINT_H)
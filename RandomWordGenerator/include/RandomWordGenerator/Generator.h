@@ -4,8 +4,12 @@
 #pragma once
 
 #include <cstdint>
+#include <iosfwd>
 #include <random>
 #include <string>
+#include <string_view>
+
+class WordFingerprint;
 
 class RandomWordGenerator
 {
@@ -15,6 +19,37 @@ public:
 
     using Table = float[ALPHABET_SIZE + 1][ALPHABET_SIZE + 1][ALPHABET_SIZE + 1][ALPHABET_SIZE+1];
 
+    //! The product of the probabilities of the characters of a word so far. It is rescaled before it can underflow, so
+    //! that the log is taken only once. Everything that scores words uses it, so that their scores are identical.
+    struct ProbabilityProduct
+    {
+        static double constexpr RESCALE_THRESHOLD = 1e-250;
+        static double constexpr RESCALE_FACTOR    = 1e250;
+        static double constexpr LOG_RESCALE       = 575.646273248511421;    //!< log(RESCALE_FACTOR)
+
+        double product = 1.0;   //!< Product of the probabilities, rescaled
+        double scale   = 0.0;   //!< Log of the rescaling
+
+        //! Multiplies by the probability of the character i given the CDF of its context. Returns false if it is 0.
+        bool multiply(float const * cdf, size_t i)
+        {
+            float p = (i > 0) ? cdf[i] - cdf[i - 1] : cdf[0];
+            if (p <= 0.0f)
+                return false;
+            product *= p;
+            if (product < RESCALE_THRESHOLD)
+            {
+                product *= RESCALE_FACTOR;
+                scale   -= LOG_RESCALE;
+            }
+            return true;
+        }
+
+        //! Returns the natural log of the probability of the word, given the CDF of the context following its last
+        //! character, or -infinity if the word cannot end there.
+        double logProbability(float const * cdf) const;
+    };
+
     //! Constructor.
     RandomWordGenerator();
 
@@ -27,18 +62,44 @@ public:
     //! Returns a generated word.
     std::string operator ()(std::minstd_rand & rng, size_t maxLength = 0);
 
+    //! Returns a word generated from the given uniforms in [0, 1), one per character. Characters beyond the count are
+    //! generated from the rng.
+    std::string operator ()(float const * uniforms, size_t count, std::minstd_rand & rng, size_t maxLength = 0);
+
+    //! Returns a generated word, appending each of its characters to a fingerprint as it is generated.
+    std::string operator ()(std::minstd_rand & rng, WordFingerprint & fingerprint, size_t maxLength = 0);
+
+    //! Returns the CDF of the character following the sequence (i0, i1, i2).
+    float const * cdf(size_t i0, size_t i1, size_t i2) const { return cdfs_[i0][i1][i2]; }
+
+    //! Returns the natural log of the probability that the word is generated.
+    double logProbability(std::string_view word) const;
+
+    //! Replaces the CDF of the character following the sequence (i0, i1, i2).
+    void setCdf(size_t i0, size_t i1, size_t i2, float const cdf[ALPHABET_SIZE + 1]);
+
+    //! Returns a checksum of the distribution table. It is the sum of a hash of each row, so it is updated in constant time
+    //! when a row is replaced.
+    uint64_t checksum() const { return checksum_; }
+
+    //! Writes the table as an image that a ModelView can use. Returns false if it cannot be written.
+    bool writeImage(std::ostream & out) const;
+
 private:
     friend std::ostream & operator <<(std::ostream & s, RandomWordGenerator const & g);
     friend std::istream & operator >>(std::istream & s, RandomWordGenerator & g);
 
-    char   nextCharacter(std::minstd_rand & rng, size_t c0, size_t c1, size_t c2);
-    size_t toIndex(char c)
+    std::string generate(float const * uniforms, size_t count, std::minstd_rand & rng, size_t maxLength, WordFingerprint * fingerprint);
+    char        nextCharacter(float u, size_t i0, size_t i1, size_t i2) const;
+    uint64_t    rowChecksum(size_t i0, size_t i1, size_t i2) const;
+    void        updateChecksum();
+    size_t toIndex(char c) const
     {
         size_t result = alphabet_.find(c);
         return (result != std::string::npos) ? result : TERMINATOR;
     }
 
-    char toCharacter(size_t i)
+    char toCharacter(size_t i) const
     {
         return (i < alphabet_.size()) ? alphabet_[i] : 0;
     }
@@ -46,6 +107,7 @@ private:
     std::uniform_real_distribution<float> randomFloat_ = std::uniform_real_distribution<float>(0.0f, 1.0f);
     std::string alphabet_ = "abcdefghijklmnopqrstuvwxyz";
     float (*cdfs_)[ALPHABET_SIZE + 1][ALPHABET_SIZE + 1][ALPHABET_SIZE + 1];
+    uint64_t checksum_ = 0;
 };
 
 //! Inserts a RandomWordGenerator into a stream.
@@ -0,0 +1,89 @@
+#if !defined(RANDOMWORDGENERATOR_HANDLEDERIVER_H)
+#define RANDOMWORDGENERATOR_HANDLEDERIVER_H
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+//! Derives unique handles (such as "mjohnson42") from full names using templates.
+//!
+//! A template is text in which {first} and {last} are replaced by the first and last name, and {f} and {l} by their
+//! initials. For example, "{f}{last}" turns "mary johnson" into "mjohnson". The templates are tried in order, and the first
+//! handle that has not been issued is used. If every one has been issued, the handle of the first template is followed by
+//! the smallest number not yet tried for it, which is kept in a counter for each prefix, so finding a free handle rarely
+//! takes more than one attempt.
+//!
+//! The issued handles are kept as 64-bit fingerprints in a sharded set. Two different handles with the same fingerprint
+//! are treated as one, which only costs a free handle and never issues a handle twice. The deriver may be used by several
+//! threads.
+class HandleDeriver
+{
+public:
+    //! Constructor. A handle is never longer than maxLength characters, unless it is 0.
+    explicit HandleDeriver(size_t maxLength = 0);
+
+    //! Destructor.
+    ~HandleDeriver();
+
+    HandleDeriver(HandleDeriver const &) = delete;
+    HandleDeriver & operator =(HandleDeriver const &) = delete;
+
+    //! Adds a template. Returns false if it has an unknown placeholder.
+    bool addTemplate(std::string_view pattern);
+
+    //! Sets handle to a unique handle for a first and last name separated by a space. Returns false if every handle that
+    //! fits in the maximum length has been issued.
+    bool derive(std::string_view name, std::string & handle);
+
+    //! Returns the number of handles issued.
+    uint64_t count() const { return count_; }
+
+    //! Forgets the issued handles.
+    void clear();
+
+private:
+    static size_t constexpr SHARD_COUNT = 64;
+
+    // A template is a list of parts
+    enum class Part : uint8_t
+    {
+        TEXT,
+        FIRST,
+        LAST,
+        FIRST_INITIAL,
+        LAST_INITIAL
+    };
+
+    struct Template
+    {
+        std::vector<Part>        parts;
+        std::vector<std::string> text;  // Text of each TEXT part, in order
+    };
+
+    // The fingerprints and counters are kept in open-addressing tables, with a key of 0 marking an empty entry
+    struct Shard
+    {
+        std::mutex            mutex;
+        std::vector<uint64_t> issued;           // Fingerprints of the handles issued
+        size_t                issuedCount = 0;
+        std::vector<uint64_t> counters;         // Pairs of a prefix fingerprint and the last number tried for it
+        size_t                counterCount = 0;
+    };
+
+    void     expand(Template const & t, std::string_view first, std::string_view last, std::string & handle) const;
+    bool     claim(uint64_t fingerprint);
+    uint64_t nextNumber(uint64_t prefix);
+
+    size_t                   maxLength_;
+    std::vector<Template>    templates_;
+    std::unique_ptr<Shard[]> shards_;
+    std::atomic<uint64_t>    count_{ 0 };
+};
+
+#endif // !defined(RANDOMWORDGENERATOR_HANDLEDERIVER_H)
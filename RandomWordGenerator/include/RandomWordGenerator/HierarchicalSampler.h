@@ -0,0 +1,60 @@
+#if !defined(RANDOMWORDGENERATOR_HIERARCHICALSAMPLER_H)
+#define RANDOMWORDGENERATOR_HIERARCHICALSAMPLER_H
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <random>
+#include <string>
+
+class RandomWordGenerator;
+
+//! Samples symbols from rows of CDFs in two levels, so the cost does not grow with the number of symbols.
+//!
+//! The symbols of each row are split into groups of GROUP_SIZE, and the CDF values of a group fill one cache line. A
+//! small table holds the upper bound of each group. Sampling first finds the group containing u in that table, and then
+//! the symbol within the group, each by counting the values not greater than u, which compilers turn into a few SIMD
+//! comparisons. Up to GROUP_SIZE * GROUP_SIZE symbols, a sample reads two cache lines. Beyond that, the group is found by
+//! a binary search of the table.
+//!
+//! The results are the same as those of a binary search of the CDF (std::upper_bound), so a sampler made from a
+//! RandomWordGenerator generates the same words from the same random number generator.
+class HierarchicalSampler
+{
+public:
+    static size_t constexpr GROUP_SIZE = 16;    //!< Number of symbols in a group, which is a 64-byte cache line of floats
+
+    //! Constructor. cdfs holds rowCount rows of symbolCount non-decreasing values, ending at 1.
+    HierarchicalSampler(float const * cdfs, size_t rowCount, size_t symbolCount);
+
+    //! Constructor. The rows are the contexts of the generator, in the order of its table.
+    explicit HierarchicalSampler(RandomWordGenerator const & generator);
+
+    //! Returns the index of the first symbol in the row whose CDF value is greater than u, or the number of symbols if
+    //! there is none.
+    size_t sample(size_t row, float u) const;
+
+    //! Returns a generated word. The sampler must have been made from a RandomWordGenerator.
+    std::string operator ()(std::minstd_rand & rng, size_t maxLength = 0) const;
+
+    //! Returns the number of rows.
+    size_t rowCount() const { return rowCount_; }
+
+    //! Returns the number of symbols in each row.
+    size_t symbolCount() const { return symbolCount_; }
+
+    //! Returns the size of the tables, in bytes.
+    size_t size() const { return rowCount_ * rowStride_ * sizeof(float); }
+
+private:
+    size_t                   rowCount_;
+    size_t                   symbolCount_;
+    size_t                   groupCount_;
+    size_t                   boundsSize_;   // Size of the table of group bounds, rounded up to a whole group
+    size_t                   rowStride_;    // Number of floats in a row: the bounds and then the groups
+    std::unique_ptr<float[]> memory_;
+    float *                  table_;        // Aligned to a cache line
+};
+
+#endif // !defined(RANDOMWORDGENERATOR_HIERARCHICALSAMPLER_H)
@@ -0,0 +1,39 @@
+#if !defined(RANDOMWORDGENERATOR_LINEPROCESSOR_H)
+#define RANDOMWORDGENERATOR_LINEPROCESSOR_H
+
+#pragma once
+
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <string_view>
+
+//! Transforms a stream of lines on several threads, keeping their order.
+//!
+//! One thread reads the input in large blocks that end at a line break, worker threads split the blocks into lines in
+//! place and call a function for each line, and the calling thread writes the output of each block in input order. The
+//! blocks are recycled through a fixed pool, so memory use does not depend on the size of the input, and reading, processing
+//! and writing overlap.
+class LineProcessor
+{
+public:
+    //! Appends the output for a line, including any line break, to output. The line does not include its line break.
+    using Function = std::function<void(std::string_view line, std::string & output, unsigned worker)>;
+
+    //! Constructor.
+    explicit LineProcessor(unsigned threadCount = 0, size_t blockSize = 1 << 20);
+
+    //! Processes every line of the input and writes the output. Returns false if the input cannot be read or the output
+    //! cannot be written.
+    bool run(std::FILE * in, std::FILE * out, Function const & f);
+
+    //! Returns the number of lines processed by the last call to run().
+    unsigned long long lineCount() const { return lineCount_; }
+
+private:
+    unsigned           threadCount_;
+    size_t             blockSize_;
+    unsigned long long lineCount_ = 0;
+};
+
+#endif // !defined(RANDOMWORDGENERATOR_LINEPROCESSOR_H)
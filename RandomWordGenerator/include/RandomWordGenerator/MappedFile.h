@@ -0,0 +1,43 @@
+#if !defined(RANDOMWORDGENERATOR_MAPPEDFILE_H)
+#define RANDOMWORDGENERATOR_MAPPEDFILE_H
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+//! A read-only memory-mapped file.
+class MappedFile
+{
+public:
+    //! Constructor.
+    MappedFile() = default;
+
+    //! Destructor.
+    ~MappedFile();
+
+    MappedFile(MappedFile const &) = delete;
+    MappedFile & operator =(MappedFile const &) = delete;
+
+    //! Maps the file into memory. Returns false if the file cannot be mapped.
+    bool open(char const * filename);
+
+    //! Unmaps the file.
+    void close();
+
+    //! Returns the contents of the file.
+    uint8_t const * data() const { return data_; }
+
+    //! Returns the size of the file.
+    size_t size() const { return size_; }
+
+private:
+    uint8_t const * data_ = nullptr;
+    size_t          size_ = 0;
+#if defined(_WIN32)
+    void * file_    = nullptr;
+    void * mapping_ = nullptr;
+#endif
+};
+
+#endif // !defined(RANDOMWORDGENERATOR_MAPPEDFILE_H)
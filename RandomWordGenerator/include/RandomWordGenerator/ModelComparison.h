@@ -0,0 +1,43 @@
+#if !defined(RANDOMWORDGENERATOR_MODELCOMPARISON_H)
+#define RANDOMWORDGENERATOR_MODELCOMPARISON_H
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+class RandomWordGenerator;
+
+//! How far the distribution of the next character moved in one context.
+struct ContextDivergence
+{
+    size_t context;     //!< Index of the context, i0 * 27 * 27 + i1 * 27 + i2
+    double occupancy;   //!< Expected number of times the context occurs in a word generated by the base model
+    double kl;          //!< KL divergence of the candidate from the base, in nats (infinite if the candidate cannot
+                        //!< generate a character that the base can)
+    double js;          //!< Jensen-Shannon divergence, in nats (at most log 2)
+};
+
+//! A comparison of a candidate model with a base model.
+//!
+//! The contexts are weighted by how often they occur in words generated by the base model, which is computed exactly by
+//! propagating the probability of each context from the start of a word. Because a word is generated one character at a
+//! time, the KL divergence between the distributions of whole words is the sum of the per-context divergences weighted by
+//! occupancy.
+struct ModelComparison
+{
+    std::vector<ContextDivergence> contexts;    //!< Contexts that occur in words generated by the base model
+    double                          wordKl;     //!< KL divergence of the distributions of words, in nats
+    double                          weightedJs; //!< Occupancy-weighted mean JS divergence per context, in nats
+    double                          expectedLength;     //!< Expected number of characters in a word, plus the terminator
+    size_t                          unsupported;        //!< Number of contexts in which the KL divergence is infinite
+
+    //! Returns the name of a context, with '^' standing for the start of the word.
+    static std::string contextName(size_t context);
+};
+
+//! Compares a candidate model with a base model, using threadCount threads (0 for all cores).
+ModelComparison compareModels(RandomWordGenerator const & base, RandomWordGenerator const & candidate, unsigned threadCount = 0);
+
+#endif // !defined(RANDOMWORDGENERATOR_MODELCOMPARISON_H)
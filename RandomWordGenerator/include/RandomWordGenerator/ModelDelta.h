@@ -0,0 +1,56 @@
+#if !defined(RANDOMWORDGENERATOR_MODELDELTA_H)
+#define RANDOMWORDGENERATOR_MODELDELTA_H
+
+#pragma once
+
+#include <cstdint>
+#include <iosfwd>
+#include <vector>
+
+#include <RandomWordGenerator/Generator.h>
+
+//! The rows of the distribution table that differ between two versions of a model.
+//!
+//! A delta records the checksums of the model it applies to and of the model it produces, so it is only applied to the
+//! right model and the result can be verified. Applying a delta costs in proportion to the number of changed rows, since
+//! the checksum of a model is updated row by row.
+class ModelDelta
+{
+public:
+    //! Returns the delta that turns base into target.
+    static ModelDelta diff(RandomWordGenerator const & base, RandomWordGenerator const & target);
+
+    //! Writes the delta. Returns false if it cannot be written.
+    bool write(std::ostream & out) const;
+
+    //! Reads a delta written by write(). Returns false if the data is not a valid delta.
+    bool read(std::istream & in);
+
+    //! Applies the delta to a model. Returns false, leaving the model unchanged, if the model's checksum is not the base
+    //! checksum or the result's checksum is not the target checksum. The model must not be in use by another thread.
+    bool apply(RandomWordGenerator & model) const;
+
+    //! Returns the number of changed rows.
+    size_t size() const { return rows_.size(); }
+
+    //! Returns the checksum of the model the delta applies to.
+    uint64_t baseChecksum() const { return baseChecksum_; }
+
+    //! Returns the checksum of the model produced by the delta.
+    uint64_t targetChecksum() const { return targetChecksum_; }
+
+private:
+    static size_t constexpr N = RandomWordGenerator::ALPHABET_SIZE + 1;
+
+    struct Row
+    {
+        uint32_t context;   // i0 * N * N + i1 * N + i2
+        float    cdf[N];
+    };
+
+    std::vector<Row> rows_;
+    uint64_t         baseChecksum_   = 0;
+    uint64_t         targetChecksum_ = 0;
+};
+
+#endif // !defined(RANDOMWORDGENERATOR_MODELDELTA_H)
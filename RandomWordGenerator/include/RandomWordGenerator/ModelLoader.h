@@ -0,0 +1,56 @@
+#if !defined(RANDOMWORDGENERATOR_MODELLOADER_H)
+#define RANDOMWORDGENERATOR_MODELLOADER_H
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class RandomWordGenerator;
+
+//! Loads and trains models concurrently on a small pool of threads.
+//!
+//! Each load returns a future for the model immediately, so a caller can start several loads and then use each model as
+//! soon as it is ready. Loads are identified by a key (normally the file name), and loading the same key again returns the
+//! same future. A model that cannot be loaded is returned as nullptr.
+class ModelLoader
+{
+public:
+    using Model  = std::shared_ptr<RandomWordGenerator>;
+    using Future = std::shared_future<Model>;
+
+    //! Constructor. If threadCount is 0, the number of cores is used, up to 4.
+    explicit ModelLoader(unsigned threadCount = 0);
+
+    //! Destructor. Waits for the loads in progress and abandons those not yet started.
+    ~ModelLoader();
+
+    ModelLoader(ModelLoader const &) = delete;
+    ModelLoader & operator =(ModelLoader const &) = delete;
+
+    //! Trains a model from a distribution file.
+    Future load(std::string const & filename);
+
+    //! Creates a model with the given function.
+    Future load(std::string const & key, std::function<Model()> create);
+
+private:
+    void work();
+
+    std::vector<std::thread>                    threads_;
+    std::deque<std::packaged_task<Model()>>     tasks_;
+    std::map<std::string, Future>               loads_;
+    std::mutex                                  mutex_;
+    std::condition_variable                     ready_;
+    bool                                        stopping_ = false;
+};
+
+#endif // !defined(RANDOMWORDGENERATOR_MODELLOADER_H)
@@ -0,0 +1,150 @@
+#if !defined(RANDOMWORDGENERATOR_MODELVIEW_H)
+#define RANDOMWORDGENERATOR_MODELVIEW_H
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// The freestanding core of the library. This header depends on nothing but <cstddef> and <cstdint>, and the code in it
+// never allocates, throws, or does I/O, so it can be used in builds without the rest of the library, the standard
+// streams, or exceptions. Models are trained and written as images by the full library (RandomWordGenerator::writeImage()
+// or the model_image tool), and an image can be embedded in the program as an array or loaded by the host.
+
+//! A minimal standard random number generator, equivalent to std::minstd_rand.
+class MinstdRandom
+{
+public:
+    static uint32_t constexpr MODULUS    = 2147483647u;
+    static uint32_t constexpr MULTIPLIER = 48271u;
+
+    //! Constructor. The sequence is the same as that of std::minstd_rand with the same seed.
+    explicit constexpr MinstdRandom(uint32_t seed = 1) noexcept
+        : state_((seed % MODULUS != 0) ? seed % MODULUS : 1)
+    {
+    }
+
+    //! Returns the next number, in [1, MODULUS - 1].
+    constexpr uint32_t operator ()() noexcept
+    {
+        state_ = (uint32_t)((uint64_t)state_ * MULTIPLIER % MODULUS);
+        return state_;
+    }
+
+    //! Returns a uniform float in [0, 1) from the next number. It is the value std::uniform_real_distribution<float>(0, 1)
+    //! returns for the same number in libstdc++.
+    float uniform() noexcept
+    {
+        float u = (float)((*this)() - 1) / (float)(MODULUS - 1);
+        return (u < 1.0f) ? u : 0.99999994f;   // The largest float below 1
+    }
+
+private:
+    uint32_t state_;
+};
+
+//! A read-only view of a model image in a buffer owned by the caller.
+//!
+//! The image is the table of a RandomWordGenerator: a header followed by the CDF of the character following each context
+//! of three characters. The words generated from a MinstdRandom are the same as the words generated by the
+//! RandomWordGenerator from a std::minstd_rand with the same seed.
+//!
+//! Image layout (native byte order, 4-byte aligned):
+//!
+//!     0   magic ("RWGm")
+//!     4   version
+//!     8   number of characters, including the terminator (27)
+//!     12  order (3)
+//!     16  checksum of the table (RandomWordGenerator::checksum()), low 32 bits and then high 32 bits
+//!     24  the CDFs, as 27^4 floats in the order of RandomWordGenerator::Table
+class ModelView
+{
+public:
+    static size_t constexpr   ALPHABET_SIZE = 26;               //!< Number of characters, not including the terminator
+    static size_t constexpr   TERMINATOR    = ALPHABET_SIZE;    //!< Index of the terminator
+    static size_t constexpr   SYMBOL_COUNT  = ALPHABET_SIZE + 1;
+    static size_t constexpr   ORDER         = 3;                //!< Number of characters in a context
+    static size_t constexpr   ROW_COUNT     = SYMBOL_COUNT * SYMBOL_COUNT * SYMBOL_COUNT;
+    static size_t constexpr   HEADER_SIZE   = 24;
+    static size_t constexpr   IMAGE_SIZE    = HEADER_SIZE + ROW_COUNT * SYMBOL_COUNT * sizeof(float);   //!< Size of an image
+    static uint32_t constexpr VERSION       = 1;
+
+    //! Returns the magic number at the start of an image.
+    static constexpr uint32_t magic() noexcept { return (uint32_t)'R' | (uint32_t)'W' << 8 | (uint32_t)'G' << 16 | (uint32_t)'m' << 24; }
+
+    //! Constructor. The view is empty until it is opened.
+    constexpr ModelView() noexcept = default;
+
+    //! Opens an image. The buffer must be 4-byte aligned and outlive the view. Returns false if it is not a valid image.
+    bool open(void const * data, size_t size) noexcept
+    {
+        cdfs_ = nullptr;
+        if (!data || size < IMAGE_SIZE || (uintptr_t)data % alignof(float) != 0)
+            return false;
+
+        uint32_t const * header = static_cast<uint32_t const *>(data);
+        if (header[0] != magic() || header[1] != VERSION || header[2] != SYMBOL_COUNT || header[3] != ORDER)
+            return false;
+
+        checksum_ = (uint64_t)header[4] | (uint64_t)header[5] << 32;
+        cdfs_     = reinterpret_cast<float const *>(static_cast<unsigned char const *>(data) + HEADER_SIZE);
+        return true;
+    }
+
+    //! Returns true if an image is open.
+    bool isOpen() const noexcept { return cdfs_ != nullptr; }
+
+    //! Returns the checksum of the table, which is that of the RandomWordGenerator the image was written from.
+    uint64_t checksum() const noexcept { return checksum_; }
+
+    //! Returns the CDF of the character following the sequence (i0, i1, i2).
+    float const * cdf(size_t i0, size_t i1, size_t i2) const noexcept
+    {
+        return cdfs_ + ((i0 * SYMBOL_COUNT + i1) * SYMBOL_COUNT + i2) * SYMBOL_COUNT;
+    }
+
+    //! Returns the index of the character following a context for a uniform u in [0, 1), which is TERMINATOR at the end of
+    //! the word.
+    size_t sample(size_t context, float u) const noexcept
+    {
+        // The number of values not greater than u is the index of the first value greater than u. The loop has no
+        // branches, so it is vectorized.
+        float const * row   = cdfs_ + context * SYMBOL_COUNT;
+        size_t        count = 0;
+        for (size_t k = 0; k < SYMBOL_COUNT; ++k)
+        {
+            count += (row[k] <= u) ? 1 : 0;
+        }
+        return (count < ALPHABET_SIZE) ? count : TERMINATOR;
+    }
+
+    //! Generates a word into a buffer of the given capacity, followed by a null. Returns the length of the word. A word
+    //! that does not fit is truncated to capacity - 1 characters.
+    size_t generate(MinstdRandom & rng, char * word, size_t capacity) const noexcept
+    {
+        if (capacity == 0)
+            return 0;
+
+        size_t length  = 0;
+        size_t context = ROW_COUNT - 1;    // (TERMINATOR, TERMINATOR, TERMINATOR)
+        if (cdfs_)
+        {
+            while (length + 1 < capacity)
+            {
+                size_t i = sample(context, rng.uniform());
+                if (i == TERMINATOR)
+                    break;
+                word[length++] = (char)('a' + i);
+                context        = context % (SYMBOL_COUNT * SYMBOL_COUNT) * SYMBOL_COUNT + i;
+            }
+        }
+        word[length] = 0;
+        return length;
+    }
+
+private:
+    float const * cdfs_     = nullptr;
+    uint64_t      checksum_ = 0;
+};
+
+#endif // !defined(RANDOMWORDGENERATOR_MODELVIEW_H)
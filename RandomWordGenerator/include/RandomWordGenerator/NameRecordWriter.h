@@ -0,0 +1,69 @@
+#if !defined(RANDOMWORDGENERATOR_NAMERECORDWRITER_H)
+#define RANDOMWORDGENERATOR_NAMERECORDWRITER_H
+
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+#include <RandomWordGenerator/BulkWriter.h>
+
+//! Writes full names as records for loading into a database.
+//!
+//! Each record is a name with an ordinal ID. A name is split at its first space into a first and a last name, and the
+//! record holds the ID, the first name, the last name, and the full name. If the records have handles, the handle follows
+//! the name after a tab and is the last column. The records are encoded directly into the buffers of a stream.
+//!
+//! Formats:
+//! - TEXT: The full name (and a tab and the handle) and a line break, with no ID.
+//! - POSTGRES: PostgreSQL binary COPY format, for a table (id bigint, first_name text, last_name text, full_name text) or
+//!   (id bigint, first_name text, last_name text, full_name text, handle text).
+//! - FIXED: Lines of fixed-width columns: the ID as 12 digits, then the first name, the last name, the full name, and the
+//!   handle, each padded with spaces to the width of its column. A name that does not fit cannot be written.
+class NameRecordWriter
+{
+public:
+    enum class Format
+    {
+        TEXT,
+        POSTGRES,
+        FIXED
+    };
+
+    struct Options
+    {
+        Format format      = Format::TEXT;
+        size_t firstWidth  = 16;        //!< Width of the first name column of FIXED records
+        size_t lastWidth   = 24;        //!< Width of the last name column of FIXED records. The full name column is wider
+                                        //!< by the first name column plus 1.
+        size_t handleWidth = 24;        //!< Width of the handle column of FIXED records
+        bool   handles     = false;     //!< True if the records have handles
+    };
+
+    //! Constructor.
+    NameRecordWriter(BulkWriter::Stream & stream, Options const & options);
+
+    //! Writes what precedes the records. Returns false if it cannot be written.
+    bool begin();
+
+    //! Writes a record. Returns false if the name does not fit or the record cannot be written.
+    bool write(uint64_t id, std::string_view name);
+
+    //! Writes what follows the records. Returns false if it cannot be written.
+    bool end();
+
+    //! Returns true if the name can be written in the format.
+    static bool fits(std::string_view name, Options const & options);
+
+    //! Returns the format named by a string (text, postgres or fixed). Returns false if there is no such format.
+    static bool parseFormat(char const * name, Format & format);
+
+private:
+    bool writeField(std::string_view value);
+    bool writePadded(std::string_view value, size_t width);
+
+    BulkWriter::Stream & stream_;
+    Options              options_;
+};
+
+#endif // !defined(RANDOMWORDGENERATOR_NAMERECORDWRITER_H)
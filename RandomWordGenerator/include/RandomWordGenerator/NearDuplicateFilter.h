@@ -0,0 +1,86 @@
+#if !defined(RANDOMWORDGENERATOR_NEARDUPLICATEFILTER_H)
+#define RANDOMWORDGENERATOR_NEARDUPLICATEFILTER_H
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <RandomWordGenerator/Filter.h>
+
+//! Rejects words that look or sound like a word it has already accepted.
+//!
+//! A word is rejected if its phonetic key (a simplified Metaphone) matches the key of an accepted word, or if it is within
+//! an edit distance of an accepted word. The keys are kept in a sharded hash set, which is the fast first check. The
+//! accepted words are indexed by every variant with up to the distance of their letters deleted. Two words within the
+//! distance always share such a variant, so a word is only compared with the accepted words sharing one of its variants.
+//! The number of variants grows quickly with the distance, so the distance should be small. Every word that is not rejected
+//! is accepted, so the filter is meant for the words issued in one batch.
+//!
+//! The filter may be used by several threads. The index is searched and updated under one lock, so two similar words
+//! checked at the same time are never both accepted.
+class NearDuplicateFilter : public RandomWordFilter
+{
+public:
+    //! Counts of the words checked by the filter.
+    struct Statistics
+    {
+        uint64_t checked;               //!< Number of words checked
+        uint64_t phoneticRejections;    //!< Number of words rejected because of their phonetic key
+        uint64_t distanceRejections;    //!< Number of words rejected because of their edit distance
+        double   seconds;               //!< Time spent checking, summed over the threads
+    };
+
+    //! Constructor. Words within maxDistance edits (insertions, deletions or substitutions) of an accepted word are
+    //! rejected. If maxDistance is 0, only the phonetic keys are checked.
+    explicit NearDuplicateFilter(unsigned maxDistance = 1);
+
+    //! Rejects the word if it is similar to an accepted word, and accepts it otherwise.
+    bool rejects(std::string_view word) override;
+
+    //! Forgets the accepted words.
+    void clear();
+
+    //! Returns the counts of the words checked so far.
+    Statistics statistics() const;
+
+    //! Returns the phonetic key of a lowercase word.
+    static std::string phoneticKey(std::string_view word);
+
+    //! Returns the edit distance between two words.
+    static unsigned editDistance(std::string_view a, std::string_view b);
+
+private:
+    static size_t constexpr SHARD_COUNT = 64;
+
+    struct Shard
+    {
+        std::mutex                      mutex;
+        std::unordered_set<std::string> keys;
+    };
+
+    bool insertKey(std::string const & key);
+    void eraseKey(std::string const & key);
+    void deletionVariants(std::string_view word, std::vector<uint64_t> & variants) const;
+    bool findWithin(std::string_view word, std::vector<uint64_t> const & variants) const;
+    void insertWord(std::string_view word, std::vector<uint64_t> const & variants);
+
+    unsigned                                    maxDistance_;
+    std::unique_ptr<Shard[]>                    shards_;
+    std::vector<std::string>                    words_;         // Accepted words
+    std::unordered_multimap<uint64_t, uint32_t> index_;         // Hash of a deletion variant and the word it came from
+    std::mutex                                  indexMutex_;
+    std::atomic<uint64_t>                       checked_{ 0 };
+    std::atomic<uint64_t>                       phoneticRejections_{ 0 };
+    std::atomic<uint64_t>                       distanceRejections_{ 0 };
+    std::atomic<uint64_t>                       nanoseconds_{ 0 };
+};
+
+#endif // !defined(RANDOMWORDGENERATOR_NEARDUPLICATEFILTER_H)
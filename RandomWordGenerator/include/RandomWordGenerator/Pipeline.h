@@ -0,0 +1,81 @@
+#if !defined(RANDOMWORDGENERATOR_PIPELINE_H)
+#define RANDOMWORDGENERATOR_PIPELINE_H
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+class WordArena;
+
+//! Runs batches of words through a chain of stages, each on its own threads.
+//!
+//! A source fills batches, any number of stages transform or filter them in place, and a sink consumes them. Adjacent
+//! stages are connected by bounded lock-free queues, and batches are recycled through a fixed pool, so memory use is
+//! bounded and a stage that falls behind makes the stages before it wait. Words within a batch keep their order, but
+//! batches may be reordered by stages with more than one thread.
+class WordPipeline
+{
+public:
+    //! Fills an empty batch. Returns false if there will be no more batches from this worker.
+    using Source = std::function<bool(WordArena & batch, unsigned worker)>;
+
+    //! Transforms or filters a batch in place. A batch left empty is recycled.
+    using Stage = std::function<void(WordArena & batch, unsigned worker)>;
+
+    //! Consumes a batch.
+    using Sink = std::function<void(WordArena const & batch, unsigned worker)>;
+
+    //! Statistics of a stage after run().
+    struct Metrics
+    {
+        std::string name;
+        unsigned    parallelism;
+        uint64_t    batches;            //!< Number of batches processed
+        uint64_t    words;              //!< Number of words processed (after the stage, for the source)
+        double      busySeconds;        //!< Time spent in the stage's function, summed over its threads
+        double      utilization;        //!< Fraction of the run time that the stage's threads were busy
+        double      averageQueueDepth;  //!< Average number of batches waiting in the input queue when a batch is taken
+        size_t      maxQueueDepth;      //!< Largest number of batches seen waiting in the input queue
+        size_t      queueCapacity;      //!< Capacity of the input queue
+    };
+
+    //! Constructor.
+    explicit WordPipeline(size_t queueCapacity = 16);
+
+    //! Destructor.
+    ~WordPipeline();
+
+    //! Sets the source.
+    void setSource(std::string const & name, Source source, unsigned parallelism = 1);
+
+    //! Appends a stage.
+    void addStage(std::string const & name, Stage stage, unsigned parallelism = 1);
+
+    //! Sets the sink.
+    void setSink(std::string const & name, Sink sink, unsigned parallelism = 1);
+
+    //! Runs the pipeline until every source worker is done or stop() is called, and every batch has reached the sink.
+    void run();
+
+    //! Makes the source workers stop producing batches. May be called from any stage.
+    void stop() { stopped_ = true; }
+
+    //! Returns the statistics of the source, each stage, and the sink, in order.
+    std::vector<Metrics> metrics() const;
+
+private:
+    struct Node;
+
+    std::vector<std::unique_ptr<Node>> nodes_;   // Source, stages, and sink
+    std::unique_ptr<Node>              sink_;
+    size_t                             queueCapacity_;
+    std::atomic<bool>                  stopped_;
+    double                             runSeconds_ = 0.0;
+};
+
+#endif // !defined(RANDOMWORDGENERATOR_PIPELINE_H)
@@ -0,0 +1,54 @@
+#if !defined(RANDOMWORDGENERATOR_PREFIXSCORER_H)
+#define RANDOMWORDGENERATOR_PREFIXSCORER_H
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <RandomWordGenerator/Generator.h>
+
+//! Computes log probabilities of a sequence of words, reusing the work done for the prefix shared with the previous word.
+//!
+//! The context and partial product after each character of the previous word are kept, so scoring a word starts from the
+//! state after the longest prefix it shares with the previous word. Consecutive words of a sorted list share long
+//! prefixes, so the work saved is roughly in proportion to the overlap. The results are exactly those of
+//! RandomWordGenerator::logProbability().
+class PrefixScorer
+{
+public:
+    //! Constructor. The generator must outlive the scorer.
+    explicit PrefixScorer(RandomWordGenerator const & generator);
+
+    //! Returns the natural log of the probability that the word is generated.
+    double logProbability(std::string_view word);
+
+    //! Forgets the previous word.
+    void reset();
+
+    //! Returns the number of characters (including terminators) in the words scored so far.
+    uint64_t characterCount() const { return characterCount_; }
+
+    //! Returns the number of those characters whose transitions were reused from the previous word.
+    uint64_t reusedCount() const { return reusedCount_; }
+
+private:
+    // State after a prefix of the previous word
+    struct State
+    {
+        RandomWordGenerator::ProbabilityProduct probability;
+        uint32_t                                i0;     // Context
+        uint32_t                                i1;
+        uint32_t                                i2;
+    };
+
+    RandomWordGenerator const & generator_;
+    std::string                 previous_;          // Scored prefix of the previous word
+    std::vector<State>          states_;            // states_[n] is the state after the first n characters of previous_
+    uint64_t                    characterCount_ = 0;
+    uint64_t                    reusedCount_    = 0;
+};
+
+#endif // !defined(RANDOMWORDGENERATOR_PREFIXSCORER_H)
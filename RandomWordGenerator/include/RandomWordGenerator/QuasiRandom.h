@@ -0,0 +1,43 @@
+#if !defined(RANDOMWORDGENERATOR_QUASIRANDOM_H)
+#define RANDOMWORDGENERATOR_QUASIRANDOM_H
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+//! A scrambled low-discrepancy sequence of points in the unit hypercube.
+//!
+//! This is the Sobol sequence with the direction numbers of Joe and Kuo (2008), scrambled with a hash-based Owen scrambling
+//! (Burley, 2020) seeded separately for each dimension. Different seeds give independent sequences that keep the
+//! stratification of the Sobol sequence.
+//!
+//! Using coordinate j of a point as the uniform for the j-th character of a word spreads a sample of words evenly over the
+//! distribution of the first characters, and then of the following ones, so a small sample repeats fewer words and covers
+//! more of the probability mass than a sample drawn with independent uniforms. The characters of a word are rarely more
+//! than DIMENSIONS long, and later characters can be generated with pseudorandom uniforms without losing much.
+class QuasiRandomSequence
+{
+public:
+    static size_t constexpr DIMENSIONS = 16;   //!< Number of coordinates of a point
+
+    //! Constructor.
+    explicit QuasiRandomSequence(uint64_t seed = 0);
+
+    //! Returns the next point, whose coordinates are in [0, 1).
+    void next(float u[DIMENSIONS]);
+
+    //! Returns the index of the next point.
+    uint32_t index() const { return index_; }
+
+    //! Sets the index of the next point.
+    void seek(uint32_t index);
+
+private:
+    uint32_t directions_[DIMENSIONS][32];
+    uint32_t seeds_[DIMENSIONS];
+    uint32_t points_[DIMENSIONS];   // Unscrambled coordinates of the next point
+    uint32_t index_ = 0;
+};
+
+#endif // !defined(RANDOMWORDGENERATOR_QUASIRANDOM_H)
@@ -0,0 +1,110 @@
+#if !defined(RANDOMWORDGENERATOR_SHAREDWORDSET_H)
+#define RANDOMWORDGENERATOR_SHAREDWORDSET_H
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+
+//! A set of words in a named shared-memory segment, which several processes can insert into concurrently.
+//!
+//! The segment holds an open-addressing hash table and an append-only arena of strings. Each slot of the table holds the
+//! 64-bit fingerprint of a word and the offset of the word in the arena. A word is inserted by claiming an empty slot with
+//! a compare-and-swap of its fingerprint, appending the word to the arena, and then publishing its offset. A process
+//! finding a slot with the same fingerprint waits for the offset and compares the words, so distinct words with the same
+//! fingerprint are both kept. No locks are taken, but a process that dies between claiming a slot and publishing the offset
+//! leaves the slot unusable. A process waits up to 10 seconds for an offset, and then marks the slot as holding no word and
+//! keeps probing, so the word can still be inserted elsewhere.
+//!
+//! The segment outlives the processes using it until it is removed. It can be saved to a file and restored later.
+class SharedWordSet
+{
+public:
+    struct Options
+    {
+        uint64_t capacity  = 1ull << 24;   //!< Expected number of words. The table has at least twice as many slots.
+        uint64_t arenaSize = 1ull << 29;   //!< Maximum total size of the words, in bytes, including 4 bytes per word
+    };
+
+    enum class Result
+    {
+        INSERTED,   //!< The word was not in the set and was inserted
+        EXISTS,     //!< The word was already in the set
+        FULL        //!< The word was not in the set and could not be inserted
+    };
+
+    //! Constructor.
+    SharedWordSet() = default;
+
+    //! Destructor. The segment is detached but not removed.
+    ~SharedWordSet();
+
+    SharedWordSet(SharedWordSet const &) = delete;
+    SharedWordSet & operator =(SharedWordSet const &) = delete;
+
+    //! Attaches to the named segment, creating it with the options if it does not exist. Returns false if the segment
+    //! cannot be created or attached.
+    bool open(std::string const & name, Options const & options);
+
+    //! Attaches to an existing named segment. Returns false if it does not exist or cannot be attached.
+    bool open(std::string const & name);
+
+    //! Detaches from the segment.
+    void close();
+
+    //! Inserts a word unless it is already in the set.
+    Result insert(std::string_view word);
+
+    //! Inserts a word unless it is already in the set, using its WordFingerprint instead of hashing it.
+    Result insert(std::string_view word, uint64_t fingerprint);
+
+    //! Returns true if the word is in the set.
+    bool contains(std::string_view word) const;
+
+    //! Returns true if the word is in the set, using its WordFingerprint instead of hashing it.
+    bool contains(std::string_view word, uint64_t fingerprint) const;
+
+    //! Returns the number of words in the set.
+    uint64_t size() const;
+
+    //! Calls the function with each word in the set, until it returns false.
+    void forEach(std::function<bool(std::string_view word)> const & f) const;
+
+    //! Saves the contents of the segment to a file. No words should be inserted while it is saved. Returns false if the
+    //! file cannot be written.
+    bool save(char const * filename) const;
+
+    //! Creates a named segment with the contents of a file written by save(). Returns false if the segment already exists
+    //! or the file cannot be read.
+    static bool restore(std::string const & name, char const * filename);
+
+    //! Removes the named segment. Processes still attached to it may continue to use it, and it is freed when the last one
+    //! detaches. Returns false if it does not exist.
+    static bool remove(std::string const & name);
+
+private:
+    struct Header;
+    struct Slot;
+
+    bool create(std::string const & name, Options const & options, bool exclusive);
+    bool attach(std::string const & name);
+    bool map(size_t size);
+
+    std::string_view wordAt(uint64_t offset) const;
+
+    uint8_t * data_    = nullptr;
+    size_t    size_    = 0;
+    Header *  header_  = nullptr;
+    Slot *    slots_   = nullptr;
+    uint8_t * arena_   = nullptr;
+#if defined(_WIN32)
+    void *    mapping_ = nullptr;
+#else
+    int       fd_      = -1;
+#endif
+};
+
+#endif // !defined(RANDOMWORDGENERATOR_SHAREDWORDSET_H)
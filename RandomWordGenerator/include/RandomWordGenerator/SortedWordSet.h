@@ -0,0 +1,63 @@
+#if !defined(RANDOMWORDGENERATOR_SORTEDWORDSET_H)
+#define RANDOMWORDGENERATOR_SORTEDWORDSET_H
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <RandomWordGenerator/Filter.h>
+#include <RandomWordGenerator/MappedFile.h>
+
+//! An immutable sorted set of words stored in a memory-mapped file.
+//!
+//! The words are front-coded in blocks. Each block starts with a complete word and every following word is stored as
+//! the length of the prefix it shares with the previous word and the remaining characters. An index of block offsets
+//! allows a binary search over the first words of the blocks, so a query decodes only one block.
+class SortedWordSet : public RandomWordFilter
+{
+public:
+    static uint32_t constexpr DEFAULT_BLOCK_SIZE = 16;  //!< Default number of words per block.
+
+    //! Writes a set containing the words. The words are sorted and duplicates are removed.
+    static bool write(std::vector<std::string> & words, std::ostream & out, uint32_t blockSize = DEFAULT_BLOCK_SIZE);
+
+    //! Maps a set written by write(). Returns false if the file cannot be mapped or is not a valid set.
+    bool open(char const * filename);
+
+    //! Returns the number of words in the set.
+    uint64_t size() const { return count_; }
+
+    //! Returns true if the set contains the word.
+    bool contains(std::string_view word) const;
+
+    //! Returns the rank of the first word that is not less than the given word.
+    uint64_t lowerBound(std::string_view word) const;
+
+    //! Returns the ranks [first, last) of the words starting with the prefix.
+    std::pair<uint64_t, uint64_t> prefixRange(std::string_view prefix) const;
+
+    //! Calls @a f for each word with a rank in [first, last), in order.
+    void forEach(uint64_t first, uint64_t last, std::function<void(std::string_view)> const & f) const;
+
+    //! Rejects words that are in the set.
+    bool rejects(std::string_view word) override { return contains(word); }
+
+private:
+    uint8_t const * block(uint32_t b) const;
+    uint8_t const * blockEnd(uint32_t b) const;
+    uint32_t        findBlock(std::string_view word) const;
+
+    MappedFile      file_;
+    uint64_t        count_      = 0;
+    uint32_t        blockSize_  = 0;
+    uint32_t        blockCount_ = 0;
+    uint8_t const * index_      = nullptr;
+};
+
+#endif // !defined(RANDOMWORDGENERATOR_SORTEDWORDSET_H)
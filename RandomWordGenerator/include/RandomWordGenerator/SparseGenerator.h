@@ -0,0 +1,58 @@
+#if !defined(RANDOMWORDGENERATOR_SPARSEGENERATOR_H)
+#define RANDOMWORDGENERATOR_SPARSEGENERATOR_H
+
+#pragma once
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <RandomWordGenerator/ContextIndex.h>
+#include <RandomWordGenerator/Generator.h>
+
+//! A generator that stores only the CDFs of the contexts that were observed.
+//!
+//! The rows of a dense table for contexts that were never observed all choose the terminator. A sparse generator keeps
+//! the other rows, packed together and found through a ContextIndex, which adds about 13 bits per context. Each row also
+//! holds its context, so a context that is not in the table is always recognized and gets the terminator row, as in the
+//! dense table. The words and log probabilities are exactly those of the RandomWordGenerator with the same table.
+class SparseGenerator
+{
+public:
+    //! Constructor. cdfs is a dense table, laid out as RandomWordGenerator::Table.
+    explicit SparseGenerator(float const * cdfs);
+
+    //! Constructor.
+    explicit SparseGenerator(RandomWordGenerator const & generator);
+
+    //! Returns a generated word.
+    std::string operator ()(std::minstd_rand & rng, size_t maxLength = 0) const;
+
+    //! Returns the CDF of the character following the sequence (i0, i1, i2).
+    float const * cdf(size_t i0, size_t i1, size_t i2) const { return row(context(i0, i1, i2)); }
+
+    //! Returns the natural log of the probability that the word is generated.
+    double logProbability(std::string_view word) const;
+
+    //! Returns the number of contexts stored.
+    size_t contextCount() const { return index_.size(); }
+
+    //! Returns the size of the rows and the index, in bytes.
+    size_t size() const { return rows_.size() * sizeof(float) + index_.memorySize(); }
+
+private:
+    static size_t constexpr N        = RandomWordGenerator::ALPHABET_SIZE + 1;
+    static size_t constexpr ROW_SIZE = N + 1;   // The CDF and then the bits of the context
+
+    static size_t context(size_t i0, size_t i1, size_t i2) { return (i0 * N + i1) * N + i2; }
+
+    float const * row(size_t context) const;
+
+    ContextIndex       index_;
+    std::vector<float> rows_;
+    float              terminatorRow_[N] = {};
+};
+
+#endif // !defined(RANDOMWORDGENERATOR_SPARSEGENERATOR_H)
@@ -0,0 +1,92 @@
+#if !defined(RANDOMWORDGENERATOR_TUNEDGENERATOR_H)
+#define RANDOMWORDGENERATOR_TUNEDGENERATOR_H
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <random>
+#include <string>
+
+class HierarchicalSampler;
+class RandomWordGenerator;
+class SparseGenerator;
+class WordFingerprint;
+
+//! Generates the words of a RandomWordGenerator with whichever of the equivalent samplers is fastest on this computer.
+//!
+//! The samplers all generate the same words from the same random number generator, but their speeds depend on the CPU
+//! and on the model:
+//! - TABLE: The generator itself, a binary search of each row of the dense table.
+//! - HIERARCHICAL: A HierarchicalSampler, which counts the values in cache-line groups with SIMD comparisons.
+//! - SPARSE: A SparseGenerator, which keeps only the observed rows, so more of the model stays in the cache.
+//!
+//! tune() checks that each sampler generates the same words as the table, measures them on the model, and uses the
+//! fastest. The decision can be saved in a cache file, keyed by the CPU model and the checksum of the model, so that later
+//! runs on the same computer with the same model skip the measurements. Until it is tuned, the generator uses TABLE.
+class TunedGenerator
+{
+public:
+    enum class Sampler
+    {
+        TABLE,
+        HIERARCHICAL,
+        SPARSE
+    };
+
+    static size_t constexpr SAMPLER_COUNT = 3;
+
+    //! Constructor. The generator must outlive this object, and must not be changed after the first call to tune().
+    explicit TunedGenerator(RandomWordGenerator & generator);
+
+    //! Destructor.
+    ~TunedGenerator();
+
+    TunedGenerator(TunedGenerator const &) = delete;
+    TunedGenerator & operator =(TunedGenerator const &) = delete;
+
+    //! Chooses the fastest sampler and returns it. If cacheFile is not null, the decision saved there for this CPU and
+    //! model is used if there is one, and otherwise the new decision is saved there.
+    Sampler tune(char const * cacheFile = nullptr);
+
+    //! Uses a sampler.
+    void use(Sampler sampler);
+
+    //! Returns a generated word.
+    std::string operator ()(std::minstd_rand & rng, size_t maxLength = 0) const;
+
+    //! Returns a generated word, appending its characters to a fingerprint.
+    std::string operator ()(std::minstd_rand & rng, WordFingerprint & fingerprint, size_t maxLength = 0) const;
+
+    //! Returns the sampler in use.
+    Sampler sampler() const { return sampler_; }
+
+    //! Returns true if the last call to tune() used a decision from the cache.
+    bool wasCached() const { return cached_; }
+
+    //! Returns the time the last call to tune() measured for a sampler to generate a word, in nanoseconds, or 0 if it was
+    //! not measured or does not generate the same words.
+    double nanosecondsPerWord(Sampler sampler) const { return times_[(size_t)sampler]; }
+
+    //! Returns the name of a sampler.
+    static char const * name(Sampler sampler);
+
+    //! Returns the model name of this computer's CPU, or "unknown".
+    static std::string cpuModel();
+
+private:
+    std::string generate(Sampler sampler, std::minstd_rand & rng, size_t maxLength) const;
+    void        build(Sampler sampler);
+    bool        isValid(Sampler sampler) const;
+    double      measure(Sampler sampler) const;
+    void        release();
+
+    RandomWordGenerator &                generator_;
+    std::unique_ptr<HierarchicalSampler> hierarchical_;
+    std::unique_ptr<SparseGenerator>     sparse_;
+    Sampler                              sampler_              = Sampler::TABLE;
+    bool                                 cached_               = false;
+    double                               times_[SAMPLER_COUNT] = {};
+};
+
+#endif // !defined(RANDOMWORDGENERATOR_TUNEDGENERATOR_H)
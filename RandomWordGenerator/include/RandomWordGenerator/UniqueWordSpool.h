@@ -0,0 +1,89 @@
+#if !defined(RANDOMWORDGENERATOR_UNIQUEWORDSPOOL_H)
+#define RANDOMWORDGENERATOR_UNIQUEWORDSPOOL_H
+
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+//! Removes duplicates from more words than fit in memory.
+//!
+//! Words are partitioned by hash into spill files in a directory, so equal words always end up in the same partition.
+//! compact() removes the duplicates from each partition in memory, one at a time, and partitions that do not fit in the
+//! memory budget are split again by a different hash. A compacted partition stays compacted as more words are added, so
+//! words can be added and compacted repeatedly until there are enough unique words.
+//!
+//! checkpoint() saves the sizes of the partitions together with an opaque state provided by the caller (for example, the
+//! states of the random number generators producing the words). After a crash, open() with resume set truncates the
+//! partitions to the sizes of the last checkpoint and returns the saved state, so the words added after it are added again
+//! exactly once.
+class UniqueWordSpool
+{
+public:
+    struct Options
+    {
+        unsigned partitionCount = 256;          //!< Number of spill files
+        size_t   memoryBudget   = 1ull << 30;   //!< Approximate limit of the memory used by the spool, in bytes
+        unsigned threadCount    = 0;            //!< Number of threads used to compact a partition, or 0 for all cores
+    };
+
+    //! Constructor.
+    UniqueWordSpool()
+        : UniqueWordSpool(Options())
+    {
+    }
+
+    //! Constructor.
+    explicit UniqueWordSpool(Options const & options);
+
+    //! Destructor.
+    ~UniqueWordSpool();
+
+    UniqueWordSpool(UniqueWordSpool const &) = delete;
+    UniqueWordSpool & operator =(UniqueWordSpool const &) = delete;
+
+    //! Opens a spool in a directory that must exist. If resume is set and the directory contains a checkpoint, the state
+    //! saved with it is returned in state. Otherwise, the spool is emptied. Returns false if the spool cannot be opened.
+    bool open(std::string const & directory, bool resume, std::string * state = nullptr);
+
+    //! Adds a word. Returns false if a spill file cannot be written.
+    bool add(std::string_view word);
+
+    //! Adds a word, using its WordFingerprint to choose the partition instead of hashing it. Returns false if a spill file
+    //! cannot be written.
+    bool add(std::string_view word, uint64_t fingerprint);
+
+    //! Removes the duplicates from every partition and returns the number of unique words, or -1 on failure.
+    int64_t compact();
+
+    //! Saves the partitions and a caller-provided state. Returns false if the checkpoint cannot be written.
+    bool checkpoint(std::string_view state);
+
+    //! Calls the function with each unique word, partition by partition, until it returns false or limit words were
+    //! visited. The spool must be compacted. Returns false if a partition cannot be read.
+    bool forEach(std::function<bool(std::string_view word)> const & f, uint64_t limit = UINT64_MAX) const;
+
+    //! Deletes the spill files and the checkpoint.
+    void remove();
+
+private:
+    std::string partitionName(unsigned i) const;
+    std::string checkpointName() const;
+    bool        flush();
+    bool        compactFile(std::string const & name, uint64_t size, unsigned level, uint64_t & count);
+
+    Options                   options_;
+    std::string               directory_;
+    std::vector<std::FILE *>  files_;
+    std::vector<std::string>  buffers_;         // Words not yet written to each partition
+    std::vector<uint64_t>     sizes_;           // Size of each partition, including its buffer
+    std::vector<uint64_t>     counts_;          // Number of words in each compacted partition
+    std::vector<bool>         compacted_;       // True if a partition has no duplicates
+    size_t                    buffered_ = 0;    // Total size of the buffers
+};
+
+#endif // !defined(RANDOMWORDGENERATOR_UNIQUEWORDSPOOL_H)
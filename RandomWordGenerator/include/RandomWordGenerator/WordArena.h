@@ -0,0 +1,114 @@
+#if !defined(RANDOMWORDGENERATOR_WORDARENA_H)
+#define RANDOMWORDGENERATOR_WORDARENA_H
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include <RandomWordGenerator/Fingerprint.h>
+
+//! A list of words stored contiguously, with the offset of each word.
+//!
+//! The words may be added with their WordFingerprints, as computed by the generator, so that later stages do not hash
+//! them again. Either every word of an arena has a fingerprint or none does.
+class WordArena
+{
+public:
+    //! Appends a word.
+    void add(std::string_view word)
+    {
+        bytes_.insert(bytes_.end(), word.begin(), word.end());
+        offsets_.push_back(bytes_.size());
+    }
+
+    //! Appends a word with its WordFingerprint.
+    void add(std::string_view word, uint64_t fingerprint)
+    {
+        add(word);
+        fingerprints_.push_back(fingerprint);
+    }
+
+    //! Returns the word at the given index.
+    std::string_view operator [](size_t i) const
+    {
+        return std::string_view(bytes_.data() + offsets_[i], (size_t)(offsets_[i + 1] - offsets_[i]));
+    }
+
+    //! Returns the WordFingerprint of the word at the given index, computing it if the word was added without one.
+    uint64_t fingerprint(size_t i) const
+    {
+        return !fingerprints_.empty() ? fingerprints_[i] : WordFingerprint::of((*this)[i]);
+    }
+
+    //! Returns true if the words were added with their fingerprints.
+    bool hasFingerprints() const { return !fingerprints_.empty(); }
+
+    //! Returns the number of words.
+    size_t size() const { return offsets_.size() - 1; }
+
+    //! Returns true if there are no words.
+    bool empty() const { return offsets_.size() == 1; }
+
+    //! Returns the total number of characters in the words.
+    size_t characterCount() const { return bytes_.size(); }
+
+    //! Reserves space for the given number of words and characters.
+    void reserve(size_t words, size_t characters)
+    {
+        offsets_.reserve(words + 1);
+        bytes_.reserve(characters);
+    }
+
+    //! Removes the words for which the predicate returns true, keeping the order of the rest. The predicate is called with
+    //! a word, or with a word and its fingerprint.
+    template <typename Predicate>
+    void removeIf(Predicate predicate)
+    {
+        size_t   kept  = 0;
+        uint64_t write = 0;
+        for (size_t i = 0; i < size(); ++i)
+        {
+            uint64_t         begin = offsets_[i];
+            uint64_t         end   = offsets_[i + 1];
+            std::string_view word(bytes_.data() + begin, (size_t)(end - begin));
+            if constexpr (std::is_invocable_v<Predicate, std::string_view, uint64_t>)
+            {
+                if (predicate(word, !fingerprints_.empty() ? fingerprints_[i] : WordFingerprint::of(word)))
+                    continue;
+            }
+            else
+            {
+                if (predicate(word))
+                    continue;
+            }
+            std::copy(bytes_.begin() + begin, bytes_.begin() + end, bytes_.begin() + write);
+            write += end - begin;
+            if (!fingerprints_.empty())
+                fingerprints_[kept] = fingerprints_[i];
+            offsets_[++kept] = write;
+        }
+        offsets_.resize(kept + 1);
+        bytes_.resize(write);
+        if (!fingerprints_.empty())
+            fingerprints_.resize(kept);
+    }
+
+    //! Removes all words, keeping the allocated space.
+    void clear()
+    {
+        bytes_.clear();
+        offsets_.resize(1);
+        fingerprints_.clear();
+    }
+
+private:
+    std::vector<char>     bytes_;
+    std::vector<uint64_t> offsets_ = std::vector<uint64_t>(1, 0);
+    std::vector<uint64_t> fingerprints_;    // Fingerprint of each word, or empty if the words have none
+};
+
+#endif // !defined(RANDOMWORDGENERATOR_WORDARENA_H)
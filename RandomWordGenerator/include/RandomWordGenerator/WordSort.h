@@ -0,0 +1,18 @@
+#if !defined(RANDOMWORDGENERATOR_WORDSORT_H)
+#define RANDOMWORDGENERATOR_WORDSORT_H
+
+#pragma once
+
+#include <cstdint>
+#include <iosfwd>
+#include <vector>
+
+class WordArena;
+
+//! Returns the indexes of the words in the arena in byte-wise lexicographic order, optionally without duplicates.
+std::vector<uint32_t> sortWords(WordArena const & arena, bool unique = true, unsigned threadCount = 0);
+
+//! Writes the words with the given indexes to a stream, one per line.
+bool writeWords(WordArena const & arena, std::vector<uint32_t> const & order, std::ostream & out);
+
+#endif // !defined(RANDOMWORDGENERATOR_WORDSORT_H)
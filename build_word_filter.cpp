@@ -0,0 +1,48 @@
+#include <RandomWordGenerator/BinaryFuseFilter.h>
+
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Builds a binary fuse filter from a list of words. Each line of the input contributes its first field, converted to
+// lower case, so both plain word lists and distribution files can be used.
+
+int main(int argc, char ** argv)
+{
+    if (argc < 3)
+    {
+        std::cerr << "usage: build_word_filter <word list> <output>" << std::endl;
+        return 1;
+    }
+
+    std::ifstream in(argv[1]);
+    if (!in.is_open())
+    {
+        std::cerr << "Cannot open '" << argv[1] << "'." << std::endl;
+        return 1;
+    }
+
+    std::vector<std::string> words;
+    std::string              line;
+    while (std::getline(in, line))
+    {
+        std::string word = line.substr(0, line.find_first_of(" \t\r"));
+        if (word.empty())
+            continue;
+        std::transform(word.begin(), word.end(), word.begin(), ::tolower);
+        words.push_back(std::move(word));
+    }
+
+    std::ofstream out(argv[2], std::ios::binary);
+    if (!out.is_open() || !BinaryFuseFilter::write(words, out))
+    {
+        std::cerr << "Cannot write '" << argv[2] << "'." << std::endl;
+        return 1;
+    }
+
+    std::cout << words.size() << " words written to '" << argv[2] << "'." << std::endl;
+    return 0;
+}
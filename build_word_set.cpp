@@ -0,0 +1,51 @@
+#include <RandomWordGenerator/SortedWordSet.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Builds a sorted word set from a list of words. Each line of the input contributes its first field, converted to lower
+// case, so both plain word lists and distribution files can be used.
+
+int main(int argc, char ** argv)
+{
+    if (argc < 3)
+    {
+        std::cerr << "usage: build_word_set <word list> <output> [block size]" << std::endl;
+        return 1;
+    }
+
+    std::ifstream in(argv[1]);
+    if (!in.is_open())
+    {
+        std::cerr << "Cannot open '" << argv[1] << "'." << std::endl;
+        return 1;
+    }
+
+    uint32_t blockSize = (argc > 3) ? (uint32_t)std::atoi(argv[3]) : SortedWordSet::DEFAULT_BLOCK_SIZE;
+
+    std::vector<std::string> words;
+    std::string              line;
+    while (std::getline(in, line))
+    {
+        std::string word = line.substr(0, line.find_first_of(" \t\r"));
+        if (word.empty())
+            continue;
+        std::transform(word.begin(), word.end(), word.begin(), ::tolower);
+        words.push_back(std::move(word));
+    }
+
+    std::ofstream out(argv[2], std::ios::binary);
+    if (!out.is_open() || !SortedWordSet::write(words, out, blockSize))
+    {
+        std::cerr << "Cannot write '" << argv[2] << "'." << std::endl;
+        return 1;
+    }
+
+    std::cout << words.size() << " words written to '" << argv[2] << "'." << std::endl;
+    return 0;
+}
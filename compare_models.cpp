@@ -0,0 +1,115 @@
+#include <RandomWordGenerator/Factory.h>
+#include <RandomWordGenerator/Generator.h>
+#include <RandomWordGenerator/ModelComparison.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+
+// Compares the models trained from two distribution files, a base and a candidate, and reports the divergence of the
+// distributions of words and the contexts that changed the most. With --max-kl or --max-js, the exit code is 2 if the
+// divergence exceeds the limit, so the comparison can be used as a release gate.
+
+namespace
+{
+    static size_t constexpr DEFAULT_TOP_COUNT = 20;
+
+    std::shared_ptr<RandomWordGenerator> train(char const * filename, bool unweighted);
+}
+
+int main(int argc, char ** argv)
+{
+    bool         unweighted = false;
+    size_t       topCount   = DEFAULT_TOP_COUNT;
+    double       maxKl      = -1.0;
+    double       maxJs      = -1.0;
+    unsigned     threads    = 0;
+    char const * files[2]   = { nullptr, nullptr };
+    int          fileCount  = 0;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "-u") == 0)
+            unweighted = true;
+        else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+            topCount = (size_t)std::atoi(argv[++i]);
+        else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc)
+            threads = (unsigned)std::atoi(argv[++i]);
+        else if (strcmp(argv[i], "--max-kl") == 0 && i + 1 < argc)
+            maxKl = std::atof(argv[++i]);
+        else if (strcmp(argv[i], "--max-js") == 0 && i + 1 < argc)
+            maxJs = std::atof(argv[++i]);
+        else if (fileCount < 2)
+            files[fileCount++] = argv[i];
+        else
+            fileCount = 3;
+    }
+
+    if (fileCount != 2)
+    {
+        std::cerr << "usage: compare_models [-u] [-n top] [-t threads] [--max-kl nats] [--max-js nats] <base file> <candidate file>"
+                  << std::endl;
+        return 1;
+    }
+
+    std::shared_ptr<RandomWordGenerator> base      = train(files[0], unweighted);
+    std::shared_ptr<RandomWordGenerator> candidate = train(files[1], unweighted);
+    if (!base || !candidate)
+        return 1;
+
+    auto                          start      = std::chrono::steady_clock::now();
+    ModelComparison               comparison = compareModels(*base, *candidate, threads);
+    std::chrono::duration<double> elapsed    = std::chrono::steady_clock::now() - start;
+
+    std::cout << "Contexts occurring in base words: " << comparison.contexts.size() << std::endl;
+    std::cout << "Expected word length:             " << comparison.expectedLength - 1.0 << std::endl;
+    std::cout << "Word KL divergence:               " << comparison.wordKl << " nats" << std::endl;
+    std::cout << "Weighted JS divergence:           " << comparison.weightedJs << " nats per character" << std::endl;
+    std::cout << "Contexts with unsupported chars:  " << comparison.unsupported << std::endl;
+    std::cout << "Compared in " << elapsed.count() * 1000.0 << " ms." << std::endl;
+
+    // The contexts that contribute the most to the divergence of words
+
+    std::vector<ContextDivergence> top = comparison.contexts;
+    topCount = std::min(topCount, top.size());
+    std::partial_sort(top.begin(), top.begin() + topCount, top.end(), [](ContextDivergence const & a, ContextDivergence const & b) {
+        return a.occupancy * a.js > b.occupancy * b.js;
+    });
+
+    std::cout << std::endl
+              << std::setw(8) << "context" << std::setw(12) << "occupancy" << std::setw(12) << "KL" << std::setw(12) << "JS"
+              << std::setw(14) << "weighted JS" << std::endl;
+    for (size_t i = 0; i < topCount; ++i)
+    {
+        ContextDivergence const & d = top[i];
+        std::cout << std::setw(8) << ModelComparison::contextName(d.context)
+                  << std::setw(12) << std::setprecision(4) << d.occupancy
+                  << std::setw(12) << d.kl
+                  << std::setw(12) << d.js
+                  << std::setw(14) << d.occupancy * d.js << std::endl;
+    }
+
+    bool failed = (maxKl >= 0.0 && !(comparison.wordKl <= maxKl)) || (maxJs >= 0.0 && !(comparison.weightedJs <= maxJs));
+    if (failed)
+    {
+        std::cerr << "The candidate model diverges from the base model by more than the limit." << std::endl;
+        return 2;
+    }
+    return 0;
+}
+
+namespace
+{
+std::shared_ptr<RandomWordGenerator> train(char const * filename, bool unweighted)
+{
+    std::shared_ptr<RandomWordGenerator> generator = RandomWordGeneratorFactory::train(filename, unweighted);
+    if (!generator)
+        std::cerr << "Cannot load '" << filename << "'." << std::endl;
+    return generator;
+}
+}
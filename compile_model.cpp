@@ -0,0 +1,265 @@
+#include <RandomWordGenerator/Factory.h>
+#include <RandomWordGenerator/Generator.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Compiles the model trained from a distribution file into C++ source. The generated class has the same generation
+// interface as RandomWordGenerator and generates the same words from the same rng, but each context reachable from the
+// start of a word has its own function, in which the character is found by a search weighted by the probabilities of the
+// characters, testing thresholds inlined as constants. The functions are called through a table indexed by the context.
+//
+// The generated source is <class name>.h and <class name>.cpp in the output directory. For best results, compile it with
+// profile-guided optimization (for example, -fprofile-generate, then a run of compiled_model_benchmark, then
+// -fprofile-use), so that the hot contexts are laid out together.
+
+namespace
+{
+    static size_t constexpr N        = RandomWordGenerator::ALPHABET_SIZE + 1;
+    static size_t constexpr CONTEXTS = N * N * N;
+    static size_t constexpr START    = CONTEXTS - 1;    // (TERMINATOR, TERMINATOR, TERMINATOR)
+
+    std::vector<bool> reachableContexts(RandomWordGenerator const & generator);
+    bool              writeHeader(std::string const & filename, std::string const & className);
+    bool              writeSource(std::string const &         filename,
+                                  std::string const &         className,
+                                  RandomWordGenerator const & generator,
+                                  std::vector<bool> const &   reachable,
+                                  char const *                distributionFile);
+    std::string       floatLiteral(float x);
+
+    struct Interval
+    {
+        float  low;
+        float  high;
+        size_t c;
+    };
+
+    void writeSearch(std::ostream & out, std::vector<Interval> const & intervals, size_t first, size_t last, int depth);
+}
+
+int main(int argc, char ** argv)
+{
+    bool                     unweighted = false;
+    std::vector<char const *> arguments;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "-u") == 0)
+            unweighted = true;
+        else
+            arguments.push_back(argv[i]);
+    }
+
+    if (arguments.size() != 3)
+    {
+        std::cerr << "usage: compile_model [-u] <distribution file> <class name> <output directory>" << std::endl;
+        return 1;
+    }
+    char const * distributionFile = arguments[0];
+    std::string  className        = arguments[1];
+    std::string  directory        = arguments[2];
+
+    std::shared_ptr<RandomWordGenerator> generator = RandomWordGeneratorFactory::train(distributionFile, unweighted);
+    if (!generator)
+    {
+        std::cerr << "Cannot load '" << distributionFile << "'." << std::endl;
+        return 1;
+    }
+
+    std::vector<bool> reachable = reachableContexts(*generator);
+    std::string       header    = directory + "/" + className + ".h";
+    std::string       source    = directory + "/" + className + ".cpp";
+    if (!writeHeader(header, className))
+    {
+        std::cerr << "Cannot write '" << header << "'." << std::endl;
+        return 1;
+    }
+    if (!writeSource(source, className, *generator, reachable, distributionFile))
+    {
+        std::cerr << "Cannot write '" << source << "'." << std::endl;
+        return 1;
+    }
+
+    std::cerr << "Compiled " << std::count(reachable.begin(), reachable.end(), true) << " reachable contexts of " << CONTEXTS
+              << "." << std::endl;
+    return 0;
+}
+
+namespace
+{
+// Returns the contexts that can occur while generating a word
+std::vector<bool> reachableContexts(RandomWordGenerator const & generator)
+{
+    std::vector<bool>   reachable(CONTEXTS, false);
+    std::vector<size_t> pending   = { START };
+    reachable[START] = true;
+    while (!pending.empty())
+    {
+        size_t context = pending.back();
+        pending.pop_back();
+
+        float const * cdf      = generator.cdf(context / (N * N), context / N % N, context % N);
+        float         previous = 0.0f;
+        for (size_t c = 0; c < RandomWordGenerator::ALPHABET_SIZE; ++c)
+        {
+            if (cdf[c] > previous)
+            {
+                size_t next = context % (N * N) * N + c;
+                if (!reachable[next])
+                {
+                    reachable[next] = true;
+                    pending.push_back(next);
+                }
+            }
+            previous = std::max(previous, cdf[c]);
+        }
+    }
+    return reachable;
+}
+
+bool writeHeader(std::string const & filename, std::string const & className)
+{
+    std::ofstream out(filename);
+    out << "// Generated by compile_model. Do not edit.\n"
+           "\n"
+           "#pragma once\n"
+           "\n"
+           "#include <cstddef>\n"
+           "#include <random>\n"
+           "#include <string>\n"
+           "\n"
+           "class " << className << "\n"
+           "{\n"
+           "public:\n"
+           "    //! Returns a generated word.\n"
+           "    std::string operator ()(std::minstd_rand & rng, size_t maxLength = 0);\n"
+           "\n"
+           "private:\n"
+           "    std::uniform_real_distribution<float> randomFloat_ = std::uniform_real_distribution<float>(0.0f, 1.0f);\n"
+           "};\n";
+    return static_cast<bool>(out);
+}
+
+bool writeSource(std::string const &         filename,
+                 std::string const &         className,
+                 RandomWordGenerator const & generator,
+                 std::vector<bool> const &   reachable,
+                 char const *                distributionFile)
+{
+    std::ofstream out(filename);
+    out << "// Generated by compile_model from " << distributionFile << ". Do not edit.\n"
+           "\n"
+           "#include \"" << className << ".h\"\n"
+           "\n"
+           "namespace\n"
+           "{\n"
+           "    int constexpr TERMINATOR = " << RandomWordGenerator::TERMINATOR << ";\n"
+           "\n"
+           "    using Next = int (*)(float u);\n"
+           "\n"
+           "    int nextUnreachable(float)\n"
+           "    {\n"
+           "        return TERMINATOR;\n"
+           "    }\n";
+
+    // Character c follows the context if cdf[c - 1] <= u < cdf[c], as found by std::upper_bound in the table-driven
+    // generator. The intervals are searched with a binary search tree split at the probability-weighted median rather than
+    // the middle, so likely characters are found in fewer tests.
+
+    for (size_t context = 0; context < CONTEXTS; ++context)
+    {
+        if (!reachable[context])
+            continue;
+
+        std::vector<Interval> intervals;
+        float const *         cdf      = generator.cdf(context / (N * N), context / N % N, context % N);
+        float                 previous = 0.0f;
+        for (size_t c = 0; c < N; ++c)
+        {
+            if (cdf[c] > previous)
+                intervals.push_back({ previous, cdf[c], c });
+            previous = std::max(previous, cdf[c]);
+        }
+        if (previous < 1.0f)
+            intervals.push_back({ previous, 1.0f, RandomWordGenerator::TERMINATOR });
+
+        // A context with a single interval does not use u
+        out << "\n    int next" << context << ((intervals.size() > 1) ? "(float u)" : "(float)") << "\n    {\n";
+        writeSearch(out, intervals, 0, intervals.size(), 2);
+        out << "    }\n";
+    }
+
+    // The functions are called through a table indexed by the context
+
+    out << "\n    Next const NEXT[" << CONTEXTS << "] =\n    {";
+    for (size_t context = 0; context < CONTEXTS; ++context)
+    {
+        out << ((context % 8 == 0) ? "\n        " : " ");
+        if (reachable[context])
+            out << "next" << context << ",";
+        else
+            out << "nextUnreachable,";
+    }
+    out << "\n    };\n"
+           "}\n"
+           "\n"
+           "std::string " << className << "::operator ()(std::minstd_rand & rng, size_t maxLength /* = 0*/)\n"
+           "{\n"
+           "    std::string word;\n"
+           "    unsigned    context = " << START << ";\n"
+           "    while (word.size() <= maxLength || maxLength == 0)\n"
+           "    {\n"
+           "        int c = NEXT[context](randomFloat_(rng));\n"
+           "        if (c == TERMINATOR)\n"
+           "            break;\n"
+           "        word += (char)('a' + c);\n"
+           "        context = context % " << N * N << " * " << N << " + c;\n"
+           "    }\n"
+           "    return word;\n"
+           "}\n";
+    return static_cast<bool>(out);
+}
+
+// Writes a search of the intervals in [first, last), which are adjacent and in order
+void writeSearch(std::ostream & out, std::vector<Interval> const & intervals, size_t first, size_t last, int depth)
+{
+    std::string indent(depth * 4, ' ');
+    if (last - first == 1)
+    {
+        out << indent << "return " << intervals[first].c << ";\n";
+        return;
+    }
+
+    // Split before the interval that best balances the probability on each side
+    float  total = intervals[last - 1].high - intervals[first].low;
+    size_t split = first + 1;
+    for (size_t i = first + 1; i < last; ++i)
+    {
+        float below     = intervals[i].low - intervals[first].low;
+        float bestBelow = intervals[split].low - intervals[first].low;
+        if (std::abs(2.0f * below - total) < std::abs(2.0f * bestBelow - total))
+            split = i;
+    }
+
+    out << indent << "if (u < " << floatLiteral(intervals[split].low) << ")\n" << indent << "{\n";
+    writeSearch(out, intervals, first, split, depth + 1);
+    out << indent << "}\n" << indent << "else\n" << indent << "{\n";
+    writeSearch(out, intervals, split, last, depth + 1);
+    out << indent << "}\n";
+}
+
+// Returns an exact C++ literal of a float
+std::string floatLiteral(float x)
+{
+    char literal[32];
+    snprintf(literal, sizeof(literal), "%af", (double)x);
+    return literal;
+}
+}
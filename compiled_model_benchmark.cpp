@@ -0,0 +1,67 @@
+#include <RandomWordGenerator/Corpus.h>
+#include <RandomWordGenerator/Factory.h>
+#include <RandomWordGenerator/Generator.h>
+
+#include "CompiledLastNameModel.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+
+// Compares the generator compiled by compile_model from a distribution file with the table-driven generator trained from
+// the same file. Both are given the same rng seed and must generate the same words.
+
+namespace
+{
+    static size_t constexpr WORD_COUNT = 2000000;
+
+    template <typename Generator>
+    double measure(Generator & generator, size_t & checksum)
+    {
+        std::minstd_rand rng(1);
+        auto             start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < WORD_COUNT; ++i)
+        {
+            std::string word = generator(rng);
+            checksum = checksum * 31 + std::hash<std::string>()(word);
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        return (double)WORD_COUNT / elapsed.count();
+    }
+}
+
+int main(int argc, char ** argv)
+{
+    if (argc < 2)
+    {
+        std::cerr << "usage: compiled_model_benchmark <distribution file>" << std::endl;
+        return 1;
+    }
+
+    RandomWordCorpus corpus;
+    if (!corpus.load(argv[1]))
+    {
+        std::cerr << "Cannot load '" << argv[1] << "'." << std::endl;
+        return 1;
+    }
+    RandomWordGeneratorFactory factory;
+    factory.analyzeCorpus(corpus);
+    std::shared_ptr<RandomWordGenerator> table = factory.create();
+    CompiledLastNameModel                compiled;
+
+    size_t tableChecksum    = 0;
+    size_t compiledChecksum = 0;
+    double tableRate        = measure(*table, tableChecksum);
+    double compiledRate     = measure(compiled, compiledChecksum);
+
+    std::cout << "table:    " << tableRate << " words/s" << std::endl;
+    std::cout << "compiled: " << compiledRate << " words/s (" << compiledRate / tableRate << "x)" << std::endl;
+    if (tableChecksum != compiledChecksum)
+    {
+        std::cerr << "The generators do not generate the same words." << std::endl;
+        return 1;
+    }
+    return 0;
+}
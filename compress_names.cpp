@@ -0,0 +1,66 @@
+#include <RandomWordGenerator/Codec.h>
+#include <RandomWordGenerator/Factory.h>
+#include <RandomWordGenerator/Generator.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+
+// Compresses (or with -d, decompresses) a list of names read from stdin to stdout, using a model trained from a
+// distribution file. The same distribution file and options must be used to decompress. With -u, every name in the
+// distribution file is weighted equally, which suits lists of distinct names better than weighting by frequency.
+
+int main(int argc, char ** argv)
+{
+    bool         decompress = false;
+    bool         unweighted = false;
+    char const * filename   = nullptr;
+    unsigned     threads    = 0;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "-d") == 0)
+            decompress = true;
+        else if (strcmp(argv[i], "-u") == 0)
+            unweighted = true;
+        else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc)
+            threads = (unsigned)std::atoi(argv[++i]);
+        else
+            filename = argv[i];
+    }
+
+    if (!filename)
+    {
+        std::cerr << "usage: compress_names [-d] [-u] [-t threads] <distribution file> < input > output" << std::endl;
+        return 1;
+    }
+
+    std::shared_ptr<RandomWordGenerator> generator = RandomWordGeneratorFactory::train(filename, unweighted);
+    if (!generator)
+    {
+        std::cerr << "Cannot load '" << filename << "'." << std::endl;
+        return 1;
+    }
+    RandomWordCodec codec(*generator);
+
+    std::ios::sync_with_stdio(false);
+    if (decompress)
+    {
+        if (!codec.decode(std::cin, std::cout, threads))
+        {
+            std::cerr << "The input is corrupt or was not compressed with '" << filename << "'." << std::endl;
+            return 1;
+        }
+    }
+    else
+    {
+        if (!codec.encode(std::cin, std::cout))
+        {
+            std::cerr << "Cannot write the output." << std::endl;
+            return 1;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,83 @@
+#include <RandomWordGenerator/WordArena.h>
+#include <RandomWordGenerator/WordSort.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+// Reads words from stdin, one per line, and writes them to stdout sorted and without duplicates. With -a, duplicates are
+// kept.
+
+namespace
+{
+    static size_t constexpr READ_BLOCK_SIZE = 1 << 20;
+}
+
+int main(int argc, char ** argv)
+{
+    bool     unique  = true;
+    unsigned threads = 0;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "-a") == 0)
+        {
+            unique = false;
+        }
+        else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc)
+        {
+            threads = (unsigned)std::atoi(argv[++i]);
+        }
+        else
+        {
+            std::cerr << "usage: export_names [-a] [-t threads] < input > output" << std::endl;
+            return 1;
+        }
+    }
+
+    // Read the words into an arena. A partial line at the end of a block is carried into the next one.
+
+    WordArena         arena;
+    std::vector<char> block(READ_BLOCK_SIZE);
+    size_t            carried = 0;
+    while (true)
+    {
+        size_t n   = fread(block.data() + carried, 1, block.size() - carried, stdin);
+        size_t end = carried + n;
+        if (n == 0)
+        {
+            if (carried > 0)
+                arena.add(std::string_view(block.data(), carried));
+            break;
+        }
+
+        char const * p    = block.data();
+        char const * last = block.data() + end;
+        for (char const * eol; (eol = static_cast<char const *>(memchr(p, '\n', last - p))) != nullptr; p = eol + 1)
+        {
+            char const * e = (eol > p && eol[-1] == '\r') ? eol - 1 : eol;
+            arena.add(std::string_view(p, e - p));
+        }
+
+        carried = last - p;
+        memmove(block.data(), p, carried);
+        if (carried == block.size())
+            block.resize(block.size() * 2);
+    }
+
+    auto                  start   = std::chrono::steady_clock::now();
+    std::vector<uint32_t> order   = sortWords(arena, unique, threads);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::cerr << "Sorted " << arena.size() << " words (" << order.size() << " written) in " << elapsed.count() << " s." << std::endl;
+
+    std::ios::sync_with_stdio(false);
+    if (!writeWords(arena, order, std::cout))
+    {
+        std::cerr << "Cannot write the output." << std::endl;
+        return 1;
+    }
+    return 0;
+}
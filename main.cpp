@@ -1,11 +1,38 @@
+#include <RandomWordGenerator/BinaryFuseFilter.h>
+#include <RandomWordGenerator/BulkWriter.h>
 #include <RandomWordGenerator/Factory.h>
+#include <RandomWordGenerator/Filter.h>
+#include <RandomWordGenerator/Fingerprint.h>
 #include <RandomWordGenerator/Generator.h>
+#include <RandomWordGenerator/HandleDeriver.h>
+#include <RandomWordGenerator/LineProcessor.h>
+#include <RandomWordGenerator/ModelDelta.h>
+#include <RandomWordGenerator/ModelLoader.h>
+#include <RandomWordGenerator/NameRecordWriter.h>
+#include <RandomWordGenerator/NearDuplicateFilter.h>
+#include <RandomWordGenerator/Pipeline.h>
+#include <RandomWordGenerator/PrefixScorer.h>
+#include <RandomWordGenerator/QuasiRandom.h>
+#include <RandomWordGenerator/SharedWordSet.h>
+#include <RandomWordGenerator/SortedWordSet.h>
+#include <RandomWordGenerator/TunedGenerator.h>
+#include <RandomWordGenerator/UniqueWordSpool.h>
+#include <RandomWordGenerator/WordArena.h>
 
+#include <atomic>
 #include <cassert>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <fstream>
 #include <iostream>
 #include <memory>
 #include <algorithm>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
 
 namespace
 {
@@ -13,55 +40,462 @@ namespace
     static char constexpr FEMALE_NAME_DISTRIBUTION_FILE_NAME[] = "C:\\Users\\John\\Projects\\NameGenerator\\dist.female.first.txt";
     static char constexpr LAST_NAME_DISTRIBUTION_FILE_NAME[]   = "C:\\Users\\John\\Projects\\NameGenerator\\dist.all.last.txt";
 
+    static int constexpr    MAX_ATTEMPTS = 1000;    // Maximum number of words generated in search of one that is not rejected
+    static size_t constexpr BATCH_SIZE   = 4096;    // Number of names in a batch in bulk generation
+    static size_t constexpr ROUND_SIZE   = 65536;   // Number of unique-mode names generated by each thread between checkpoints
+
+    using FilterList = std::vector<std::unique_ptr<RandomWordFilter>>;
+
+    enum class ScoreMode
+    {
+        NONE,
+        SCORE,      // Append the log probability of the line under each model
+        CLASSIFY,   // Append the name of the most likely model
+        FLAG        // Append 1 if the line is unlikely under every model, or 0 otherwise
+    };
+
+    struct NameGenerators
+    {
+        RandomWordGenerator & male;
+        RandomWordGenerator & female;
+        RandomWordGenerator & last;
+    };
+
+    // Generators of bulk names, using the fastest sampler if they are tuned
+    struct TunedGenerators
+    {
+        TunedGenerator & male;
+        TunedGenerator & female;
+        TunedGenerator & last;
+    };
+
+    using DeltaList = std::vector<ModelDelta>;
+
     std::shared_ptr<RandomWordGenerator> createGeneratorFromDistribution(char const * filename);
+    std::shared_ptr<RandomWordGenerator> createPatchedGenerator(std::string const &              filename,
+                                                                DeltaList const &                deltas,
+                                                                std::vector<std::atomic<bool>> & applied);
+    std::string generate(RandomWordGenerator & generator, std::minstd_rand & rng, FilterList & filters, QuasiRandomSequence * sequence = nullptr);
+    bool        rejects(FilterList & filters, std::string_view name);
+    void        appendScore(std::string & output, double score);
+    bool        scoreLines(NameGenerators const & generators, ScoreMode mode, double threshold, unsigned threadCount, bool stats);
+    std::string generateName(RandomWordGenerator & first,
+                             RandomWordGenerator & last,
+                             std::minstd_rand &    rng,
+                             FilterList &          filters,
+                             NearDuplicateFilter * distinct,
+                             QuasiRandomSequence * firstSequence,
+                             QuasiRandomSequence * lastSequence);
+    std::string generateFullName(TunedGenerators const & generators, std::minstd_rand & rng, uint64_t & fingerprint);
+    bool        generateBulk(TunedGenerators const &           generators,
+                             FilterList &                      filters,
+                             NearDuplicateFilter *             distinct,
+                             SharedWordSet *                   shared,
+                             HandleDeriver *                   handles,
+                             unsigned long long                count,
+                             unsigned                          threadCount,
+                             BulkWriter &                      writer,
+                             NameRecordWriter::Options const & records,
+                             bool                              stats);
+    bool        generateUnique(TunedGenerators const &           generators,
+                               FilterList &                      filters,
+                               unsigned long long                count,
+                               unsigned                          threadCount,
+                               std::string const &               spoolDirectory,
+                               bool                              resume,
+                               size_t                            memoryBudget,
+                               BulkWriter &                      writer,
+                               NameRecordWriter::Options const & records);
 }
 
 int main(int argc, char ** argv)
 {
-    // Create a male name generator
+    // Words in any of these are never issued
+
+    FilterList                                  filters;
+    std::vector<std::unique_ptr<SortedWordSet>> confirmations;
+    BinaryFuseFilter *                          lastFilter = nullptr;
+
+    // Bulk generation
+
+    char const *              outputFileName = nullptr;
+    unsigned long long        count          = 0;
+    unsigned                  threadCount    = std::max(std::thread::hardware_concurrency(), 1u);
+    BulkWriter::Options       writerOptions;
+    NameRecordWriter::Options recordOptions;
+    bool                      stats          = false;
+    char const *              spoolDirectory = nullptr;
+    bool                      resume         = false;
+    size_t                    memoryBudget   = UniqueWordSpool::Options().memoryBudget;
+    char const *              autotuneCache  = nullptr;
+
+    // Full names too similar to a name already issued are never issued
+
+    std::unique_ptr<NearDuplicateFilter> distinct;
+
+    // Full names already issued by any process sharing the segment are never issued
+
+    char const *           sharedName      = nullptr;
+    SharedWordSet::Options sharedOptions;
+    uint64_t               sharedArenaSize = 0;     // 0 to size the arena from the capacity and the longest name
+
+    // Templates of the handles derived from the full names
 
-    std::shared_ptr<RandomWordGenerator> maleNameGenerator = createGeneratorFromDistribution(MALE_NAME_DISTRIBUTION_FILE_NAME);
-    if (!maleNameGenerator)
+    std::vector<char const *> handleTemplates;
+
+    // Deltas applied to whichever models they match
+
+    DeltaList                deltas;
+    std::vector<std::string> deltaFileNames;
+
+    // Sample generation
+
+    bool quasi = false;
+
+    // Scoring of names read from stdin
+
+    ScoreMode scoreMode = ScoreMode::NONE;
+    double    threshold = 0.0;
+
+    std::string maleFileName   = MALE_NAME_DISTRIBUTION_FILE_NAME;
+    std::string femaleFileName = FEMALE_NAME_DISTRIBUTION_FILE_NAME;
+    std::string lastFileName   = LAST_NAME_DISTRIBUTION_FILE_NAME;
+
+    for (int i = 1; i < argc; ++i)
     {
-        std::cerr << "Cannot create word generator from '" << MALE_NAME_DISTRIBUTION_FILE_NAME << "'." << std::endl;
+        if (strcmp(argv[i], "--data") == 0 && i + 1 < argc)
+        {
+            std::string directory = std::string(argv[++i]) + "/";
+            maleFileName          = directory + "dist.male.first.txt";
+            femaleFileName        = directory + "dist.female.first.txt";
+            lastFileName          = directory + "dist.all.last.txt";
+        }
+        else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc)
+        {
+            outputFileName = argv[++i];
+        }
+        else if (strcmp(argv[i], "--count") == 0 && i + 1 < argc)
+        {
+            count = std::strtoull(argv[++i], nullptr, 10);
+        }
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+        {
+            threadCount = std::max(std::atoi(argv[++i]), 1);
+        }
+        else if (strcmp(argv[i], "--direct") == 0)
+        {
+            writerOptions.direct = true;
+        }
+        else if (strcmp(argv[i], "--format") == 0 && i + 1 < argc)
+        {
+            if (!NameRecordWriter::parseFormat(argv[++i], recordOptions.format))
+            {
+                std::cerr << "Unknown format '" << argv[i] << "'." << std::endl;
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--stats") == 0)
+        {
+            stats = true;
+        }
+        else if (strcmp(argv[i], "--unique") == 0 && i + 1 < argc)
+        {
+            spoolDirectory = argv[++i];
+        }
+        else if (strcmp(argv[i], "--resume") == 0)
+        {
+            resume = true;
+        }
+        else if (strcmp(argv[i], "--memory") == 0 && i + 1 < argc)
+        {
+            memoryBudget = (size_t)std::strtoull(argv[++i], nullptr, 10) << 20;
+        }
+        else if (strcmp(argv[i], "--autotune") == 0 && i + 1 < argc)
+        {
+            autotuneCache = argv[++i];
+        }
+        else if (strcmp(argv[i], "--score") == 0)
+        {
+            scoreMode = ScoreMode::SCORE;
+        }
+        else if (strcmp(argv[i], "--classify") == 0)
+        {
+            scoreMode = ScoreMode::CLASSIFY;
+        }
+        else if (strcmp(argv[i], "--flag") == 0 && i + 1 < argc)
+        {
+            scoreMode = ScoreMode::FLAG;
+            threshold = std::atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--patch") == 0 && i + 1 < argc)
+        {
+            std::ifstream in(argv[++i], std::ios::binary);
+            ModelDelta    delta;
+            if (!in.is_open() || !delta.read(in))
+            {
+                std::cerr << "Cannot read model delta '" << argv[i] << "'." << std::endl;
+                return 1;
+            }
+            deltas.push_back(std::move(delta));
+            deltaFileNames.push_back(argv[i]);
+        }
+        else if (strcmp(argv[i], "--distinct") == 0 && i + 1 < argc)
+        {
+            distinct = std::make_unique<NearDuplicateFilter>((unsigned)strtoul(argv[++i], nullptr, 10));
+        }
+        else if (strcmp(argv[i], "--shared") == 0 && i + 1 < argc)
+        {
+            sharedName = argv[++i];
+        }
+        else if (strcmp(argv[i], "--shared-capacity") == 0 && i + 1 < argc)
+        {
+            sharedOptions.capacity = strtoull(argv[++i], nullptr, 10);
+        }
+        else if (strcmp(argv[i], "--shared-arena") == 0 && i + 1 < argc)
+        {
+            sharedArenaSize = std::strtoull(argv[++i], nullptr, 10) << 20;
+        }
+        else if (strcmp(argv[i], "--handle") == 0 && i + 1 < argc)
+        {
+            handleTemplates.push_back(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--quasi") == 0)
+        {
+            quasi = true;
+        }
+        else if (strcmp(argv[i], "--exclude") == 0 && i + 1 < argc)
+        {
+            auto set = std::make_unique<SortedWordSet>();
+            if (!set->open(argv[++i]))
+            {
+                std::cerr << "Cannot open word set '" << argv[i] << "'." << std::endl;
+                return 1;
+            }
+            filters.push_back(std::move(set));
+        }
+        else if (strcmp(argv[i], "--exclude-filter") == 0 && i + 1 < argc)
+        {
+            auto filter = std::make_unique<BinaryFuseFilter>();
+            if (!filter->open(argv[++i]))
+            {
+                std::cerr << "Cannot open word filter '" << argv[i] << "'." << std::endl;
+                return 1;
+            }
+            lastFilter = filter.get();
+            filters.push_back(std::move(filter));
+        }
+        else if (strcmp(argv[i], "--confirm") == 0 && i + 1 < argc && lastFilter)
+        {
+            // Words found in the preceding filter are only rejected if they are also in this set
+            auto set = std::make_unique<SortedWordSet>();
+            if (!set->open(argv[++i]))
+            {
+                std::cerr << "Cannot open word set '" << argv[i] << "'." << std::endl;
+                return 1;
+            }
+            lastFilter->setConfirmation(set.get());
+            confirmations.push_back(std::move(set));
+        }
+        else
+        {
+            std::cerr << "usage: generate_name [--data <directory>] [--patch <model delta>]... [--quasi] [--distinct <distance>]" << std::endl
+                      << "                     [--output <file> --count <n> [--threads <n>] [--direct] [--stats] [--autotune <cache file>]" << std::endl
+                      << "                      [--format text | postgres | fixed] [--handle <template>]..." << std::endl
+                      << "                      [--unique <spool directory> [--resume] [--memory <MB>]]" << std::endl
+                      << "                      [--shared <segment name> [--shared-capacity <names>] [--shared-arena <MB>]]]" << std::endl
+                      << "                     [--score | --classify | --flag <threshold> [--threads <n>] [--stats] < names]" << std::endl
+                      << "                     [--exclude <word set>]... [--exclude-filter <word filter> [--confirm <word set>]]..." << std::endl;
+            return 1;
+        }
+    }
+
+    if ((distinct || sharedName || !handleTemplates.empty()) && spoolDirectory)
+    {
+        std::cerr << (distinct ? "--distinct" : (sharedName ? "--shared" : "--handle")) << " cannot be used with --unique." << std::endl;
         return 1;
     }
 
-    // Create a female name generator
+    // Unless its size is given, the arena of a new shared word set has room for the capacity in names as long as the full
+    // name column of fixed-width records, each with its 4-byte length. A set that fills up stops the job cleanly.
 
-    std::shared_ptr<RandomWordGenerator> femaleNameGenerator = createGeneratorFromDistribution(FEMALE_NAME_DISTRIBUTION_FILE_NAME);
-    if (!femaleNameGenerator)
+    sharedOptions.arenaSize = sharedArenaSize
+                            ? sharedArenaSize
+                            : sharedOptions.capacity * (4 + recordOptions.firstWidth + 1 + recordOptions.lastWidth);
+
+    // Handles fit in their column of fixed-width records
+
+    std::unique_ptr<HandleDeriver> handles;
+    if (!handleTemplates.empty())
     {
-        std::cerr << "Cannot create word generator from '" << FEMALE_NAME_DISTRIBUTION_FILE_NAME << "'." << std::endl;
-        return 1;
+        recordOptions.handles = true;
+        handles = std::make_unique<HandleDeriver>(recordOptions.format == NameRecordWriter::Format::FIXED ? recordOptions.handleWidth : 0);
+        for (char const * pattern : handleTemplates)
+        {
+            if (!handles->addTemplate(pattern))
+            {
+                std::cerr << "Invalid handle template '" << pattern << "'." << std::endl;
+                return 1;
+            }
+        }
+    }
+
+    // Load the male, female and last name generators concurrently. Each one is waited for when it is first needed.
+
+    std::vector<std::atomic<bool>> applied(deltas.size());
+    ModelLoader                    loader;
+    ModelLoader::Future maleNameModel   = loader.load(maleFileName, [&] { return createPatchedGenerator(maleFileName, deltas, applied); });
+    ModelLoader::Future femaleNameModel = loader.load(femaleFileName, [&] { return createPatchedGenerator(femaleFileName, deltas, applied); });
+    ModelLoader::Future lastNameModel   = loader.load(lastFileName, [&] { return createPatchedGenerator(lastFileName, deltas, applied); });
+
+    auto wait = [](ModelLoader::Future const & model, std::string const & filename) {
+        std::shared_ptr<RandomWordGenerator> generator = model.get();
+        if (!generator)
+            std::cerr << "Cannot create word generator from '" << filename << "'." << std::endl;
+        return generator;
+    };
+
+    if (scoreMode != ScoreMode::NONE || outputFileName || !deltas.empty())
+    {
+        if (!wait(maleNameModel, maleFileName) || !wait(femaleNameModel, femaleFileName) || !wait(lastNameModel, lastFileName))
+            return 1;
     }
 
-    // Create a last name generator
+    // A delta that matches none of the models is stale, damaged or meant for other data, and ignoring it would silently
+    // produce names from the unpatched models
 
-    std::shared_ptr<RandomWordGenerator> lastNameGenerator = createGeneratorFromDistribution(LAST_NAME_DISTRIBUTION_FILE_NAME);
-    if (!lastNameGenerator)
+    bool unapplied = false;
+    for (size_t i = 0; i < deltas.size(); ++i)
     {
-        std::cerr << "Cannot create word generator from '" << LAST_NAME_DISTRIBUTION_FILE_NAME << "'." << std::endl;
+        if (!applied[i])
+        {
+            std::cerr << "Model delta '" << deltaFileNames[i] << "' does not apply to any of the models, or is damaged." << std::endl;
+            unapplied = true;
+        }
+    }
+    if (unapplied)
         return 1;
+
+    // Score, classify or flag the names read from stdin
+
+    if (scoreMode != ScoreMode::NONE)
+    {
+        NameGenerators generators = { *maleNameModel.get(), *femaleNameModel.get(), *lastNameModel.get() };
+        if (!scoreLines(generators, scoreMode, threshold, threadCount, stats))
+        {
+            std::cerr << "Cannot score the names." << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+
+    // Write the requested number of full names to a file
+
+    if (outputFileName)
+    {
+        BulkWriter writer;
+        if (!writer.open(outputFileName, writerOptions))
+        {
+            std::cerr << "Cannot open '" << outputFileName << "'." << std::endl;
+            return 1;
+        }
+
+        // The segment is created by the first process to open it and removed with shared_word_set when the job is done
+
+        SharedWordSet shared;
+        if (sharedName && !shared.open(sharedName, sharedOptions))
+        {
+            std::cerr << "Cannot open the shared word set '" << sharedName << "'." << std::endl;
+            return 1;
+        }
+
+        // With --autotune, each model uses the sampler that is fastest on this computer, as measured now or in an earlier
+        // run with the same model
+
+        TunedGenerator  male(*maleNameModel.get());
+        TunedGenerator  female(*femaleNameModel.get());
+        TunedGenerator  last(*lastNameModel.get());
+        TunedGenerators generators = { male, female, last };
+        if (autotuneCache)
+        {
+            static char const * const MODEL_NAMES[] = { "male", "female", "last" };
+            TunedGenerator *          tuned[]       = { &male, &female, &last };
+            for (size_t m = 0; m < 3; ++m)
+            {
+                tuned[m]->tune(autotuneCache);
+                if (stats)
+                {
+                    std::cerr << "autotune: " << MODEL_NAMES[m] << " uses " << TunedGenerator::name(tuned[m]->sampler());
+                    if (tuned[m]->wasCached())
+                    {
+                        std::cerr << " (cached for " << TunedGenerator::cpuModel() << ")";
+                    }
+                    else
+                    {
+                        for (size_t s = 0; s < TunedGenerator::SAMPLER_COUNT; ++s)
+                        {
+                            TunedGenerator::Sampler sampler = (TunedGenerator::Sampler)s;
+                            std::cerr << (s == 0 ? " (" : ", ") << TunedGenerator::name(sampler) << " "
+                                      << tuned[m]->nanosecondsPerWord(sampler) << " ns";
+                        }
+                        std::cerr << ")";
+                    }
+                    std::cerr << std::endl;
+                }
+            }
+        }
+
+        bool ok = spoolDirectory
+                ? generateUnique(generators, filters, count, threadCount, spoolDirectory, resume, memoryBudget, writer, recordOptions)
+                : generateBulk(generators, filters, distinct.get(), sharedName ? &shared : nullptr, handles.get(), count, threadCount, writer, recordOptions, stats);
+        if (!writer.close() || !ok)
+        {
+            std::cerr << "Cannot write '" << outputFileName << "'." << std::endl;
+            return 1;
+        }
+        return 0;
     }
 
     std::random_device entropy;
     std::minstd_rand   rng(entropy());
 
+    // With --quasi, the names are spread more evenly over each distribution by driving each generator with its own
+    // quasi-random sequence
+
+    std::unique_ptr<QuasiRandomSequence> maleSequence;
+    std::unique_ptr<QuasiRandomSequence> femaleSequence;
+    std::unique_ptr<QuasiRandomSequence> lastSequence;
+    if (quasi)
+    {
+        maleSequence   = std::make_unique<QuasiRandomSequence>(entropy());
+        femaleSequence = std::make_unique<QuasiRandomSequence>(entropy());
+        lastSequence   = std::make_unique<QuasiRandomSequence>(entropy());
+    }
+
     // Generate 10 male names
 
+    std::shared_ptr<RandomWordGenerator> maleNameGenerator = wait(maleNameModel, maleFileName);
+    std::shared_ptr<RandomWordGenerator> lastNameGenerator = wait(lastNameModel, lastFileName);
+    if (!maleNameGenerator || !lastNameGenerator)
+        return 1;
+
     std::cout << std::endl << "---- Male Names ----" << std::endl;
     for (int i = 0; i < 10; ++i)
     {
-        std::cout << (*maleNameGenerator)(rng) << ' ' << (*lastNameGenerator)(rng) << std::endl;
+        std::cout << generateName(*maleNameGenerator, *lastNameGenerator, rng, filters, distinct.get(), maleSequence.get(), lastSequence.get())
+                  << std::endl;
     }
 
     // Generate 10 female names
 
+    std::shared_ptr<RandomWordGenerator> femaleNameGenerator = wait(femaleNameModel, femaleFileName);
+    if (!femaleNameGenerator)
+        return 1;
+
     std::cout << std::endl << "---- Female Names ----" << std::endl;
     for (int i = 0; i < 10; ++i)
     {
-        std::cout << (*femaleNameGenerator)(rng) << ' ' << (*lastNameGenerator)(rng) << std::endl;
+        std::cout << generateName(*femaleNameGenerator, *lastNameGenerator, rng, filters, distinct.get(), femaleSequence.get(), lastSequence.get())
+                  << std::endl;
     }
 
     return 0;
@@ -109,4 +543,510 @@ std::shared_ptr<RandomWordGenerator> createGeneratorFromDistribution(char const
 
     return factory.create();
 }
+
+// Creates a generator from a distribution file, and then applies each delta whose base is the generator's current model.
+// Deltas may be chained, in any order. The deltas that are applied are marked in applied, which is shared by the models.
+std::shared_ptr<RandomWordGenerator> createPatchedGenerator(std::string const &              filename,
+                                                            DeltaList const &                deltas,
+                                                            std::vector<std::atomic<bool>> & applied)
+{
+    std::shared_ptr<RandomWordGenerator> generator = createGeneratorFromDistribution(filename.c_str());
+    if (!generator)
+        return generator;
+
+    std::vector<bool> done(deltas.size(), false);
+    for (bool progress = true; progress;)
+    {
+        progress = false;
+        for (size_t i = 0; i < deltas.size(); ++i)
+        {
+            if (!done[i] && deltas[i].apply(*generator))
+            {
+                done[i]    = true;
+                applied[i] = true;
+                progress   = true;
+            }
+        }
+    }
+    return generator;
+}
+
+// Returns a generated word that is not rejected by any of the filters, or an empty string if none was found. The
+// characters are generated with the next points of the sequence, if there is one.
+std::string generate(RandomWordGenerator & generator, std::minstd_rand & rng, FilterList & filters, QuasiRandomSequence * sequence)
+{
+    for (int attempt = 0; attempt < MAX_ATTEMPTS; ++attempt)
+    {
+        std::string word;
+        if (sequence)
+        {
+            float u[QuasiRandomSequence::DIMENSIONS];
+            sequence->next(u);
+            word = generator(u, QuasiRandomSequence::DIMENSIONS, rng);
+        }
+        else
+        {
+            word = generator(rng);
+        }
+        bool        rejected = std::any_of(filters.begin(), filters.end(), [&word](auto & filter) { return filter->rejects(word); });
+        if (!rejected)
+            return word;
+    }
+    return std::string();
+}
+
+// Returns a full name whose words are not rejected by any of the filters. If distinct is not null, the name is also not
+// similar to any name it has already accepted, or it is empty if no such name was found.
+std::string generateName(RandomWordGenerator & first,
+                         RandomWordGenerator & last,
+                         std::minstd_rand &    rng,
+                         FilterList &          filters,
+                         NearDuplicateFilter * distinct,
+                         QuasiRandomSequence * firstSequence,
+                         QuasiRandomSequence * lastSequence)
+{
+    for (int attempts = 0; attempts < MAX_ATTEMPTS; ++attempts)
+    {
+        std::string name = generate(first, rng, filters, firstSequence) + ' ' + generate(last, rng, filters, lastSequence);
+        if (!distinct || !distinct->rejects(name))
+            return name;
+    }
+    return std::string();
+}
+
+// Returns a full name from a first name model chosen at random and the last name model, and its WordFingerprint, which
+// is computed as the name is generated
+std::string generateFullName(TunedGenerators const & generators, std::minstd_rand & rng, uint64_t & fingerprint)
+{
+    TunedGenerator & first = (rng() & 1) ? generators.male : generators.female;
+    WordFingerprint  f;
+    std::string      name = first(rng, f);
+    name += ' ';
+    f.append(' ');
+    name       += generators.last(rng, f);
+    fingerprint = f.value();
+    return name;
+}
+
+// Returns true if the first or last name of a full name is rejected by any of the filters
+bool rejects(FilterList & filters, std::string_view name)
+{
+    size_t           space = name.find(' ');
+    std::string_view first = name.substr(0, space);
+    std::string_view last  = name.substr(space + 1);
+    return std::any_of(filters.begin(), filters.end(), [&](auto & filter) { return filter->rejects(first) || filter->rejects(last); });
+}
+
+// Appends a log probability with 3 decimals. This is much faster than formatting it with printf.
+void appendScore(std::string & output, double score)
+{
+    if (std::isinf(score) || std::isnan(score))
+    {
+        output += std::isnan(score) ? "nan" : (score < 0.0 ? "-inf" : "inf");
+        return;
+    }
+
+    long long thousandths = std::llround(score * 1000.0);
+    if (thousandths < 0)
+    {
+        output += '-';
+        thousandths = -thousandths;
+    }
+    output += std::to_string(thousandths / 1000);
+    char fraction[4] = { '.', (char)('0' + thousandths / 100 % 10), (char)('0' + thousandths / 10 % 10), (char)('0' + thousandths % 10) };
+    output.append(fraction, 4);
+}
+
+// Reads names from stdin, one per line, and writes each one to stdout followed by a tab and its annotation. The names are
+// lowercased and scored by each model in parallel, and the output is in input order. With ScoreMode::FLAG, a name is
+// unlikely if its best log probability per character (including the terminator) is below the threshold. Each thread
+// scores consecutive lines and resumes each name from the prefix it shares with the previous one, so sorted input is
+// scored much faster.
+bool scoreLines(NameGenerators const & generators, ScoreMode mode, double threshold, unsigned threadCount, bool stats)
+{
+    static char const * const MODEL_NAMES[] = { "male", "female", "last" };
+    RandomWordGenerator const * models[]     = { &generators.male, &generators.female, &generators.last };
+
+    char lowercase[256];
+    for (int c = 0; c < 256; ++c)
+    {
+        lowercase[c] = (c >= 'A' && c <= 'Z') ? (char)(c - 'A' + 'a') : (char)c;
+    }
+
+    std::vector<std::string>  scratch(threadCount);
+    std::vector<PrefixScorer> scorers;  // 3 per thread, one for each model
+    for (unsigned t = 0; t < threadCount; ++t)
+    {
+        for (auto model : models)
+        {
+            scorers.emplace_back(*model);
+        }
+    }
+
+    LineProcessor processor(threadCount);
+    bool          ok = processor.run(stdin, stdout, [&](std::string_view line, std::string & output, unsigned worker) {
+        std::string & name = scratch[worker];
+        name.resize(line.size());
+        for (size_t i = 0; i < line.size(); ++i)
+        {
+            name[i] = lowercase[(uint8_t)line[i]];
+        }
+
+        output.append(line.data(), line.size());
+
+        double scores[3];
+        size_t best = 0;
+        for (size_t m = 0; m < 3; ++m)
+        {
+            scores[m] = scorers[worker * 3 + m].logProbability(name);
+            if (scores[m] > scores[best])
+                best = m;
+        }
+
+        switch (mode)
+        {
+            case ScoreMode::SCORE:
+                for (double score : scores)
+                {
+                    output += '\t';
+                    appendScore(output, score);
+                }
+                break;
+            case ScoreMode::CLASSIFY:
+                output += '\t';
+                output += std::isinf(scores[best]) ? "none" : MODEL_NAMES[best];
+                break;
+            case ScoreMode::FLAG:
+                output += (scores[best] / (double)(name.size() + 1) < threshold) ? "\t1" : "\t0";
+                break;
+            default:
+                break;
+        }
+        output += '\n';
+    });
+
+    if (stats)
+    {
+        uint64_t characters = 0;
+        uint64_t reused     = 0;
+        for (auto const & scorer : scorers)
+        {
+            characters += scorer.characterCount();
+            reused     += scorer.reusedCount();
+        }
+        std::cerr << processor.lineCount() << " names scored, " << reused * 100.0 / (double)std::max<uint64_t>(characters, 1)
+                  << "% of the characters reused from the previous name" << std::endl;
+    }
+
+    return ok;
+}
+
+// Generates full names with a pipeline: several threads generate batches of names, several threads remove the names
+// with a word rejected by any of the filters, several threads remove the names similar to names already accepted if
+// distinct is not null, several threads remove the names already issued by any process sharing the set if shared is not
+// null, several threads append a unique handle to each name if handles is not null, and one thread writes the names as
+// records with consecutive IDs until there are enough. Names that do not fit in the records are never generated. The
+// names carry the fingerprints computed as they were generated, so the shared set does not hash them again. The filters
+// must be safe to use from multiple threads.
+bool generateBulk(TunedGenerators const &           generators,
+                  FilterList &                      filters,
+                  NearDuplicateFilter *             distinct,
+                  SharedWordSet *                   shared,
+                  HandleDeriver *                   handles,
+                  unsigned long long                count,
+                  unsigned                          threadCount,
+                  BulkWriter &                      writer,
+                  NameRecordWriter::Options const & records,
+                  bool                              stats)
+{
+    if (count == 0)
+        return true;
+
+    std::random_device            entropy;
+    std::vector<std::minstd_rand> rngs;
+    for (unsigned t = 0; t < threadCount; ++t)
+    {
+        rngs.emplace_back(entropy());
+    }
+
+    WordPipeline pipeline;
+
+    pipeline.setSource("generate", [&](WordArena & batch, unsigned worker) {
+        std::minstd_rand & rng = rngs[worker];
+        for (size_t i = 0; i < BATCH_SIZE; ++i)
+        {
+            uint64_t    fingerprint;
+            std::string name = generateFullName(generators, rng, fingerprint);
+            if (NameRecordWriter::fits(name, records))
+                batch.add(name, fingerprint);
+        }
+        return true;
+    }, threadCount);
+
+    if (!filters.empty())
+    {
+        pipeline.addStage("filter", [&](WordArena & batch, unsigned) {
+            batch.removeIf([&](std::string_view name) { return rejects(filters, name); });
+        }, threadCount);
+    }
+
+    if (distinct)
+    {
+        pipeline.addStage("distinct", [&](WordArena & batch, unsigned) {
+            batch.removeIf([&](std::string_view name) { return distinct->rejects(name); });
+        }, threadCount);
+    }
+
+    // Only the names this job writes are inserted into the shared set, since it is sized for them. A name reserves one of
+    // the count places before it is inserted, and gives it back unless it is inserted.
+
+    std::atomic<bool>               sharedFull(false);
+    std::atomic<unsigned long long> sharedReserved(0);
+    std::atomic<unsigned long long> sharedInserted(0);
+    if (shared)
+    {
+        pipeline.addStage("shared", [&](WordArena & batch, unsigned) {
+            batch.removeIf([&](std::string_view name, uint64_t fingerprint) {
+                if (sharedReserved.fetch_add(1) >= count)
+                {
+                    --sharedReserved;
+                    return true;
+                }
+                SharedWordSet::Result result = shared->insert(name, fingerprint);
+                if (result != SharedWordSet::Result::INSERTED)
+                {
+                    --sharedReserved;
+                    if (result == SharedWordSet::Result::FULL && !sharedFull.exchange(true))
+                        pipeline.stop();
+                    return true;
+                }
+                if (sharedInserted.fetch_add(1) + 1 == count)
+                    pipeline.stop();
+                return false;
+            });
+        }, threadCount);
+    }
+
+    // Each name is followed by a tab and its handle
+
+    std::vector<WordArena>   derived(threadCount);
+    std::vector<std::string> handleScratch(threadCount);
+    std::vector<std::string> lineScratch(threadCount);
+    std::atomic<bool>        handlesExhausted(false);
+    if (handles)
+    {
+        pipeline.addStage("handles", [&](WordArena & batch, unsigned worker) {
+            WordArena &   out    = derived[worker];
+            std::string & handle = handleScratch[worker];
+            std::string & line   = lineScratch[worker];
+            out.clear();
+            out.reserve(batch.size(), batch.characterCount() * 2);
+            for (size_t i = 0; i < batch.size(); ++i)
+            {
+                if (!handles->derive(batch[i], handle))
+                {
+                    if (!handlesExhausted.exchange(true))
+                        pipeline.stop();
+                    continue;
+                }
+                line.assign(batch[i]);
+                line += '\t';
+                line += handle;
+                out.add(line);
+            }
+            std::swap(batch, out);
+        }, threadCount);
+    }
+
+    BulkWriter::Stream stream(writer);
+    NameRecordWriter   recordWriter(stream, records);
+    unsigned long long written = 0;
+    bool               ok      = recordWriter.begin();
+    pipeline.setSink("write", [&](WordArena const & batch, unsigned) {
+        for (size_t i = 0; i < batch.size() && written < count; ++i, ++written)
+        {
+            ok = recordWriter.write(written + 1, batch[i]) && ok;
+        }
+        if (written == count)
+            pipeline.stop();
+    });
+
+    pipeline.run();
+    ok = recordWriter.end() && ok;
+    ok = stream.flush() && ok;
+
+    if (sharedFull)
+    {
+        std::cerr << "The shared word set is full." << std::endl;
+        ok = false;
+    }
+
+    if (handlesExhausted)
+    {
+        std::cerr << "No more handles fit in the handle column." << std::endl;
+        ok = false;
+    }
+
+    if (stats)
+    {
+        for (auto const & m : pipeline.metrics())
+        {
+            std::cerr << m.name << ": " << m.parallelism << " threads, " << m.batches << " batches, " << m.words << " names, "
+                      << m.words / std::max(m.busySeconds / m.parallelism, 1e-9) << " names/s, "
+                      << m.utilization * 100.0 << "% busy, queue depth " << m.averageQueueDepth << " (max " << m.maxQueueDepth
+                      << " of " << m.queueCapacity << ")" << std::endl;
+        }
+        if (distinct)
+        {
+            NearDuplicateFilter::Statistics s = distinct->statistics();
+            double                          n = (double)std::max<uint64_t>(s.checked, 1);
+            std::cerr << "distinct: " << s.checked << " names checked, "
+                      << s.phoneticRejections * 100.0 / n << "% rejected by sound, "
+                      << s.distanceRejections * 100.0 / n << "% rejected by spelling, "
+                      << s.checked / std::max(s.seconds, 1e-9) << " names/s" << std::endl;
+        }
+    }
+
+    return ok;
+}
+
+// Generates unique full names using a disk-backed spool. Names are generated in rounds, and each thread generates its
+// share of a round with its own random number generator, so the states of the generators at the end of a round determine
+// all of the names that follow. The spool is checkpointed with those states after every round, so an interrupted run
+// resumed with the same directory and number of threads continues where it stopped. The spool is compacted whenever
+// enough names have been generated to make up the shortfall, until there are enough unique names.
+bool generateUnique(TunedGenerators const &           generators,
+                    FilterList &                      filters,
+                    unsigned long long                count,
+                    unsigned                          threadCount,
+                    std::string const &               spoolDirectory,
+                    bool                              resume,
+                    size_t                            memoryBudget,
+                    BulkWriter &                      writer,
+                    NameRecordWriter::Options const & records)
+{
+    UniqueWordSpool::Options options;
+    options.memoryBudget = memoryBudget;
+    options.threadCount  = threadCount;
+    UniqueWordSpool spool(options);
+
+    std::string state;
+    if (!spool.open(spoolDirectory, resume, &state))
+    {
+        std::cerr << "Cannot open the spool in '" << spoolDirectory << "'." << std::endl;
+        return false;
+    }
+
+    std::vector<std::minstd_rand> rngs(threadCount);
+    int64_t                       unique = 0;
+    if (!state.empty())
+    {
+        std::istringstream in(state);
+        unsigned           savedThreadCount = 0;
+        in >> savedThreadCount;
+        if (savedThreadCount != threadCount)
+        {
+            std::cerr << "The spool in '" << spoolDirectory << "' must be resumed with " << savedThreadCount << " threads." << std::endl;
+            return false;
+        }
+        for (auto & rng : rngs)
+        {
+            in >> rng;
+        }
+        unique = spool.compact();
+    }
+    else
+    {
+        std::random_device entropy;
+        for (auto & rng : rngs)
+        {
+            rng.seed(entropy());
+        }
+    }
+
+    std::vector<WordArena> arenas(threadCount);
+    while (unique >= 0 && (unsigned long long)unique < count)
+    {
+        // Generate the shortfall and a little more, since some of the new names are duplicates
+
+        unsigned long long shortfall = count - (unsigned long long)unique;
+        unsigned long long target    = shortfall + shortfall / 16 + 1;
+        for (unsigned long long generated = 0; generated < target;)
+        {
+            size_t share = (size_t)std::min<unsigned long long>(ROUND_SIZE, (target - generated + threadCount - 1) / threadCount);
+
+            std::vector<std::thread> threads;
+            for (unsigned t = 0; t < threadCount; ++t)
+            {
+                threads.emplace_back([&, t] {
+                    std::minstd_rand & rng   = rngs[t];
+                    WordArena &        arena = arenas[t];
+                    arena.clear();
+                    for (size_t i = 0; i < share; ++i)
+                    {
+                        uint64_t    fingerprint;
+                        std::string name = generateFullName(generators, rng, fingerprint);
+                        if (!rejects(filters, name) && NameRecordWriter::fits(name, records))
+                            arena.add(name, fingerprint);
+                    }
+                });
+            }
+            for (auto & thread : threads)
+            {
+                thread.join();
+            }
+
+            for (auto const & arena : arenas)
+            {
+                for (size_t i = 0; i < arena.size(); ++i)
+                {
+                    if (!spool.add(arena[i], arena.fingerprint(i)))
+                    {
+                        std::cerr << "Cannot write the spool in '" << spoolDirectory << "'." << std::endl;
+                        return false;
+                    }
+                }
+            }
+            generated += share * threadCount;
+
+            std::ostringstream out;
+            out << threadCount;
+            for (auto const & rng : rngs)
+            {
+                out << ' ' << rng;
+            }
+            if (!spool.checkpoint(out.str()))
+            {
+                std::cerr << "Cannot write the checkpoint in '" << spoolDirectory << "'." << std::endl;
+                return false;
+            }
+        }
+
+        int64_t previous = unique;
+        unique = spool.compact();
+        if (unique >= 0 && unique == previous)
+        {
+            std::cerr << "Cannot generate " << count << " unique names. Only " << unique << " were found." << std::endl;
+            return false;
+        }
+    }
+    if (unique < 0)
+    {
+        std::cerr << "Cannot compact the spool in '" << spoolDirectory << "'." << std::endl;
+        return false;
+    }
+
+    BulkWriter::Stream stream(writer);
+    NameRecordWriter   recordWriter(stream, records);
+    uint64_t           id = 0;
+    bool               ok = recordWriter.begin() && spool.forEach([&](std::string_view name) {
+        return recordWriter.write(++id, name);
+    }, count);
+    ok = recordWriter.end() && ok;
+    ok = stream.flush() && ok;
+
+    if (ok)
+        spool.remove();
+    return ok;
+}
 }
@@ -0,0 +1,75 @@
+#include <RandomWordGenerator/Factory.h>
+#include <RandomWordGenerator/Generator.h>
+#include <RandomWordGenerator/ModelDelta.h>
+
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+
+// Writes the delta between the models trained from two distribution files, a base and a target. The delta can be applied
+// to the base model with generate_name --patch. The delta is verified by applying it to a copy of the base model.
+
+namespace
+{
+    std::shared_ptr<RandomWordGenerator> train(char const * filename, bool unweighted);
+}
+
+int main(int argc, char ** argv)
+{
+    bool         unweighted = false;
+    char const * files[3]   = { nullptr, nullptr, nullptr };
+    int          fileCount  = 0;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "-u") == 0)
+            unweighted = true;
+        else if (fileCount < 3)
+            files[fileCount++] = argv[i];
+        else
+            fileCount = 4;
+    }
+
+    if (fileCount != 3)
+    {
+        std::cerr << "usage: model_delta [-u] <base file> <target file> <delta file>" << std::endl;
+        return 1;
+    }
+
+    std::shared_ptr<RandomWordGenerator> base   = train(files[0], unweighted);
+    std::shared_ptr<RandomWordGenerator> target = train(files[1], unweighted);
+    if (!base || !target)
+        return 1;
+
+    ModelDelta    delta = ModelDelta::diff(*base, *target);
+    std::ofstream out(files[2], std::ios::binary);
+    if (!out.is_open() || !delta.write(out))
+    {
+        std::cerr << "Cannot write '" << files[2] << "'." << std::endl;
+        return 1;
+    }
+
+    if (!delta.apply(*base) || base->checksum() != target->checksum())
+    {
+        std::cerr << "The delta does not reproduce the target model." << std::endl;
+        return 1;
+    }
+
+    std::cerr << std::hex << std::setfill('0')
+              << "Wrote " << std::dec << delta.size() << " changed rows, base " << std::hex << std::setw(16) << delta.baseChecksum()
+              << ", target " << std::setw(16) << delta.targetChecksum() << "." << std::endl;
+    return 0;
+}
+
+namespace
+{
+std::shared_ptr<RandomWordGenerator> train(char const * filename, bool unweighted)
+{
+    std::shared_ptr<RandomWordGenerator> generator = RandomWordGeneratorFactory::train(filename, unweighted);
+    if (!generator)
+        std::cerr << "Cannot load '" << filename << "'." << std::endl;
+    return generator;
+}
+}
@@ -0,0 +1,124 @@
+#include <RandomWordGenerator/Factory.h>
+#include <RandomWordGenerator/Generator.h>
+#include <RandomWordGenerator/ModelView.h>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+
+// Writes the model trained from a distribution file as an image for ModelView, the freestanding core. With -a, the image
+// is written instead as a C++ header defining an aligned array with the given name, so it can be compiled into a program
+// that has no file system.
+
+namespace
+{
+    std::shared_ptr<RandomWordGenerator> train(char const * filename, bool unweighted);
+    bool                                 writeArray(std::string const & image, char const * name, char const * source, std::ostream & out);
+}
+
+int main(int argc, char ** argv)
+{
+    bool         unweighted = false;
+    char const * arrayName  = nullptr;
+    char const * files[2]   = { nullptr, nullptr };
+    int          fileCount  = 0;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "-u") == 0)
+            unweighted = true;
+        else if (strcmp(argv[i], "-a") == 0 && i + 1 < argc)
+            arrayName = argv[++i];
+        else if (fileCount < 2)
+            files[fileCount++] = argv[i];
+        else
+            fileCount = 3;
+    }
+
+    if (fileCount != 2)
+    {
+        std::cerr << "usage: model_image [-u] [-a <array name>] <distribution file> <output file>" << std::endl;
+        return 1;
+    }
+
+    std::shared_ptr<RandomWordGenerator> generator = train(files[0], unweighted);
+    if (!generator)
+        return 1;
+
+    std::ostringstream image;
+    generator->writeImage(image);
+
+    // Check that the image is usable before writing it
+    std::string bytes = image.str();
+    ModelView   view;
+    alignas(float) static char buffer[ModelView::IMAGE_SIZE];
+    memcpy(buffer, bytes.data(), std::min(bytes.size(), sizeof(buffer)));
+    if (bytes.size() != ModelView::IMAGE_SIZE || !view.open(buffer, sizeof(buffer)) || view.checksum() != generator->checksum())
+    {
+        std::cerr << "The image is not valid." << std::endl;
+        return 1;
+    }
+
+    std::ofstream out(files[1], arrayName ? std::ios::out : std::ios::binary);
+    bool          ok = out.is_open();
+    if (ok)
+    {
+        if (arrayName)
+            ok = writeArray(bytes, arrayName, files[0], out);
+        else
+            ok = (bool)out.write(bytes.data(), bytes.size());
+    }
+    if (!ok)
+    {
+        std::cerr << "Cannot write '" << files[1] << "'." << std::endl;
+        return 1;
+    }
+
+    std::cerr << std::hex << std::setfill('0') << "Wrote " << std::dec << bytes.size() << " bytes, checksum " << std::hex
+              << std::setw(16) << generator->checksum() << "." << std::endl;
+    return 0;
+}
+
+namespace
+{
+std::shared_ptr<RandomWordGenerator> train(char const * filename, bool unweighted)
+{
+    std::shared_ptr<RandomWordGenerator> generator = RandomWordGeneratorFactory::train(filename, unweighted);
+    if (!generator)
+        std::cerr << "Cannot load '" << filename << "'." << std::endl;
+    return generator;
+}
+
+// Writes the image as a header defining an array of bytes
+bool writeArray(std::string const & image, char const * name, char const * source, std::ostream & out)
+{
+    static char const DIGITS[] = "0123456789abcdef";
+
+    out << "// Model image generated by model_image from " << source << ". Open it with ModelView::open(" << name << ", sizeof("
+        << name << ")).\n\n"
+        << "#pragma once\n\n"
+        << "alignas(4) static unsigned char const " << name << "[] =\n{\n";
+
+    std::string line;
+    for (size_t i = 0; i < image.size(); ++i)
+    {
+        uint8_t b = (uint8_t)image[i];
+        line += (i % 16 == 0) ? "    0x" : " 0x";
+        line += DIGITS[b >> 4];
+        line += DIGITS[b & 15];
+        line += ',';
+        if (i % 16 == 15 || i + 1 == image.size())
+        {
+            out << line << '\n';
+            line.clear();
+        }
+    }
+    out << "};\n";
+    return (bool)out;
+}
+}
@@ -0,0 +1,106 @@
+#include <RandomWordGenerator/Corpus.h>
+#include <RandomWordGenerator/Factory.h>
+#include <RandomWordGenerator/Generator.h>
+#include <RandomWordGenerator/QuasiRandom.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <unordered_set>
+
+// Compares samples of words generated with pseudorandom uniforms and with a quasi-random sequence. For each sample size,
+// reports the average number of distinct words, the probability mass that they cover, and the generation rate.
+
+namespace
+{
+    static size_t constexpr SAMPLE_SIZES[] = { 100, 1000, 10000, 100000 };
+    static int constexpr    DEFAULT_TRIALS = 20;
+
+    struct Result
+    {
+        double distinct = 0.0;  // Number of distinct words
+        double mass     = 0.0;  // Sum of the probabilities of the distinct words
+        double rate     = 0.0;  // Words generated per second
+    };
+
+    template <typename Generate>
+    Result measure(RandomWordGenerator const & generator, size_t size, Generate generate)
+    {
+        std::unordered_set<std::string> words;
+        auto                            start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < size; ++i)
+        {
+            words.insert(generate());
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        Result result;
+        result.distinct = (double)words.size();
+        for (auto const & word : words)
+        {
+            result.mass += std::exp(generator.logProbability(word));
+        }
+        result.rate = (double)size / elapsed.count();
+        return result;
+    }
+}
+
+int main(int argc, char ** argv)
+{
+    if (argc < 2)
+    {
+        std::cerr << "usage: sample_coverage <distribution file> [trials]" << std::endl;
+        return 1;
+    }
+    int trials = (argc > 2) ? std::max(std::atoi(argv[2]), 1) : DEFAULT_TRIALS;
+
+    RandomWordCorpus corpus;
+    if (!corpus.load(argv[1]))
+    {
+        std::cerr << "Cannot load '" << argv[1] << "'." << std::endl;
+        return 1;
+    }
+    RandomWordGeneratorFactory factory;
+    factory.analyzeCorpus(corpus);
+    std::shared_ptr<RandomWordGenerator> generator = factory.create();
+
+    std::cout << std::setw(8) << "draws"
+              << std::setw(14) << "distinct" << std::setw(14) << "distinct QMC"
+              << std::setw(12) << "mass" << std::setw(12) << "mass QMC"
+              << std::setw(14) << "words/s" << std::setw(14) << "words/s QMC" << std::endl;
+
+    for (size_t size : SAMPLE_SIZES)
+    {
+        Result pseudo;
+        Result quasi;
+        for (int t = 0; t < trials; ++t)
+        {
+            std::minstd_rand rng((unsigned)(t + 1));
+            Result           r = measure(*generator, size, [&] { return (*generator)(rng); });
+            pseudo.distinct += r.distinct / trials;
+            pseudo.mass     += r.mass / trials;
+            pseudo.rate     += r.rate / trials;
+
+            QuasiRandomSequence sequence((uint64_t)t + 1);
+            float               u[QuasiRandomSequence::DIMENSIONS];
+            r = measure(*generator, size, [&] {
+                sequence.next(u);
+                return (*generator)(u, QuasiRandomSequence::DIMENSIONS, rng);
+            });
+            quasi.distinct += r.distinct / trials;
+            quasi.mass     += r.mass / trials;
+            quasi.rate     += r.rate / trials;
+        }
+
+        std::cout << std::fixed
+                  << std::setw(8) << size
+                  << std::setw(14) << std::setprecision(1) << pseudo.distinct << std::setw(14) << quasi.distinct
+                  << std::setw(12) << std::setprecision(4) << pseudo.mass << std::setw(12) << quasi.mass
+                  << std::setw(14) << std::setprecision(0) << pseudo.rate << std::setw(14) << quasi.rate << std::endl;
+    }
+    return 0;
+}
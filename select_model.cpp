@@ -0,0 +1,211 @@
+#include <RandomWordGenerator/Corpus.h>
+#include <RandomWordGenerator/Factory.h>
+#include <RandomWordGenerator/Generator.h>
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    static float constexpr SMOOTHING_VALUES[]         = { 0.0f, 0.01f, 0.1f, 1.0f };
+    static float constexpr PRUNING_THRESHOLD_VALUES[] = { 0.0f, 0.001f, 0.01f };
+    static int constexpr   QUANTIZATION_VALUES[]      = { 0, 16, 8 };
+
+    static size_t constexpr THROUGHPUT_SAMPLE_SIZE = 100000;
+
+    struct Configuration
+    {
+        float smoothing;
+        float pruningThreshold;
+        int   quantization;
+    };
+
+    struct Result
+    {
+        double coverage;    // Fraction of held-out words that can be generated
+        double perplexity;  // Per-character perplexity of the held-out words that can be generated
+        size_t modelBytes;  // Size of the model stored as a sparse table
+        double throughput;  // Words generated per second
+        bool   pareto;
+    };
+
+    Result evaluate(Configuration const & configuration, RandomWordCorpus const & training, RandomWordCorpus const & heldOut);
+    size_t sparseModelSize(RandomWordGenerator const & generator, int quantization);
+    bool   dominates(Result const & a, Result const & b);
+}
+
+int main(int argc, char ** argv)
+{
+    if (argc < 3)
+    {
+        std::cerr << "usage: select_model <training file> <held-out file> [threads]" << std::endl;
+        return 1;
+    }
+
+    RandomWordCorpus training;
+    if (!training.load(argv[1]))
+    {
+        std::cerr << "Cannot load '" << argv[1] << "'." << std::endl;
+        return 1;
+    }
+
+    RandomWordCorpus heldOut;
+    if (!heldOut.load(argv[2]))
+    {
+        std::cerr << "Cannot load '" << argv[2] << "'." << std::endl;
+        return 1;
+    }
+
+    unsigned threadCount = (argc > 3) ? (unsigned)std::atoi(argv[3]) : std::thread::hardware_concurrency();
+    if (threadCount == 0)
+        threadCount = 1;
+
+    // Build the grid
+
+    std::vector<Configuration> configurations;
+    for (float smoothing : SMOOTHING_VALUES)
+    {
+        for (float threshold : PRUNING_THRESHOLD_VALUES)
+        {
+            for (int quantization : QUANTIZATION_VALUES)
+            {
+                configurations.push_back({ smoothing, threshold, quantization });
+            }
+        }
+    }
+
+    // Evaluate the configurations in parallel. Every worker reads the same corpora.
+
+    std::vector<Result>      results(configurations.size());
+    std::atomic<size_t>      next(0);
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < threadCount; ++t)
+    {
+        workers.emplace_back([&] {
+            for (size_t i = next++; i < configurations.size(); i = next++)
+            {
+                results[i] = evaluate(configurations[i], training, heldOut);
+            }
+        });
+    }
+    for (auto & worker : workers)
+    {
+        worker.join();
+    }
+
+    // Flag the configurations that are not dominated by any other
+
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        results[i].pareto = true;
+        for (size_t j = 0; j < results.size() && results[i].pareto; ++j)
+        {
+            if (j != i && dominates(results[j], results[i]))
+                results[i].pareto = false;
+        }
+    }
+
+    std::cout << "smoothing  pruning  quantization  coverage  perplexity  model bytes  words/s" << std::endl;
+    for (size_t i = 0; i < configurations.size(); ++i)
+    {
+        Configuration const & c = configurations[i];
+        Result const &        r = results[i];
+        std::cout << std::setw(9) << c.smoothing << ' '
+                  << std::setw(8) << c.pruningThreshold << ' '
+                  << std::setw(13) << c.quantization << ' '
+                  << std::setw(9) << std::fixed << std::setprecision(4) << r.coverage << ' '
+                  << std::setw(11) << r.perplexity << ' '
+                  << std::setw(12) << r.modelBytes << ' '
+                  << std::setw(8) << std::setprecision(0) << r.throughput
+                  << (r.pareto ? "  *" : "") << std::endl;
+        std::cout.unsetf(std::ios::floatfield);
+        std::cout << std::setprecision(6);
+    }
+    std::cout << "* Pareto-optimal (coverage, perplexity, model bytes, words/s)" << std::endl;
+
+    return 0;
+}
+
+namespace
+{
+Result evaluate(Configuration const & configuration, RandomWordCorpus const & training, RandomWordCorpus const & heldOut)
+{
+    RandomWordGeneratorFactory factory;
+    factory.setSmoothing(configuration.smoothing);
+    factory.setPruningThreshold(configuration.pruningThreshold);
+    factory.setQuantization(configuration.quantization);
+    factory.analyzeCorpus(training);
+    std::shared_ptr<RandomWordGenerator> generator = factory.create();
+
+    Result result;
+
+    // Perplexity of the held-out words
+
+    double logProbability = 0.0;
+    size_t characters     = 0;
+    size_t covered        = 0;
+    for (size_t i = 0; i < heldOut.size(); ++i)
+    {
+        double p = generator->logProbability(heldOut.word(i));
+        if (std::isfinite(p))
+        {
+            logProbability += p;
+            characters     += heldOut.word(i).size() + 1;
+            ++covered;
+        }
+    }
+    result.coverage   = (heldOut.size() > 0) ? (double)covered / (double)heldOut.size() : 0.0;
+    result.perplexity = (characters > 0) ? std::exp(-logProbability / (double)characters) : INFINITY;
+
+    result.modelBytes = sparseModelSize(*generator, configuration.quantization);
+
+    // Generation throughput
+
+    std::minstd_rand rng(1);
+    size_t           totalLength = 0;
+    auto             start       = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < THROUGHPUT_SAMPLE_SIZE; ++i)
+    {
+        totalLength += (*generator)(rng).size();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    result.throughput = (elapsed.count() > 0.0) ? THROUGHPUT_SAMPLE_SIZE / elapsed.count() : 0.0;
+
+    return result;
+}
+
+// Returns the size of the model if only the contexts that can choose something other than the terminator are stored, each
+// with a CDF entry per character, plus a 32-bit offset per context.
+size_t sparseModelSize(RandomWordGenerator const & generator, int quantization)
+{
+    size_t entryBytes = (quantization > 0) ? (size_t)(quantization + 7) / 8 : sizeof(float);
+    size_t rows       = 0;
+    for (size_t i = 0; i < RandomWordGenerator::ALPHABET_SIZE + 1; ++i)
+    {
+        for (size_t j = 0; j < RandomWordGenerator::ALPHABET_SIZE + 1; ++j)
+        {
+            for (size_t k = 0; k < RandomWordGenerator::ALPHABET_SIZE + 1; ++k)
+            {
+                if (generator.cdf(i, j, k)[RandomWordGenerator::TERMINATOR - 1] > 0.0f)
+                    ++rows;
+            }
+        }
+    }
+    size_t contexts = (RandomWordGenerator::ALPHABET_SIZE + 1) * (RandomWordGenerator::ALPHABET_SIZE + 1) * (RandomWordGenerator::ALPHABET_SIZE + 1);
+    return rows * (RandomWordGenerator::ALPHABET_SIZE + 1) * entryBytes + contexts * sizeof(uint32_t);
+}
+
+bool dominates(Result const & a, Result const & b)
+{
+    bool noWorse = a.coverage >= b.coverage && a.perplexity <= b.perplexity && a.modelBytes <= b.modelBytes && a.throughput >= b.throughput;
+    bool better  = a.coverage > b.coverage || a.perplexity < b.perplexity || a.modelBytes < b.modelBytes || a.throughput > b.throughput;
+    return noWorse && better;
+}
+}
@@ -0,0 +1,91 @@
+#include <RandomWordGenerator/SharedWordSet.h>
+
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+// Manages the shared-memory word sets used by generate_name --shared. After a job, a set can be exported as a word list
+// (for example, to build a word set for --exclude), saved to a file and restored for a later job, or removed.
+
+int main(int argc, char ** argv)
+{
+    char const * command = (argc >= 3) ? argv[1] : "";
+    std::string  name    = (argc >= 3) ? argv[2] : "";
+
+    if (strcmp(command, "remove") == 0 && argc == 3)
+    {
+        if (!SharedWordSet::remove(name))
+        {
+            std::cerr << "Cannot remove '" << name << "'." << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+
+    if (strcmp(command, "restore") == 0 && argc == 4)
+    {
+        if (!SharedWordSet::restore(name, argv[3]))
+        {
+            std::cerr << "Cannot restore '" << name << "' from '" << argv[3] << "'." << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+
+    bool save   = strcmp(command, "save") == 0 && argc == 4;
+    bool output = strcmp(command, "export") == 0 && (argc == 3 || argc == 4);
+    bool info   = strcmp(command, "info") == 0 && argc == 3;
+    if (!save && !output && !info)
+    {
+        std::cerr << "usage: shared_word_set info <name>" << std::endl
+                  << "       shared_word_set export <name> [<word list>]" << std::endl
+                  << "       shared_word_set save <name> <file>" << std::endl
+                  << "       shared_word_set restore <name> <file>" << std::endl
+                  << "       shared_word_set remove <name>" << std::endl;
+        return 1;
+    }
+
+    SharedWordSet set;
+    if (!set.open(name))
+    {
+        std::cerr << "Cannot open '" << name << "'." << std::endl;
+        return 1;
+    }
+
+    if (info)
+    {
+        std::cout << set.size() << " words" << std::endl;
+        return 0;
+    }
+
+    if (save)
+    {
+        if (!set.save(argv[3]))
+        {
+            std::cerr << "Cannot write '" << argv[3] << "'." << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+
+    std::FILE * out = (argc == 4) ? std::fopen(argv[3], "wb") : stdout;
+    if (!out)
+    {
+        std::cerr << "Cannot open '" << argv[3] << "'." << std::endl;
+        return 1;
+    }
+    bool ok = true;
+    set.forEach([&](std::string_view word) {
+        ok = std::fwrite(word.data(), 1, word.size(), out) == word.size() && std::fputc('\n', out) != EOF;
+        return ok;
+    });
+    ok = std::fflush(out) == 0 && ok;
+    if (out != stdout)
+        ok = std::fclose(out) == 0 && ok;
+    if (!ok)
+    {
+        std::cerr << "Cannot write the words." << std::endl;
+        return 1;
+    }
+    return 0;
+}